@@ -41,10 +41,19 @@
 #include <kth/node/sessions/session_outbound.hpp>
 #endif
 
+#include <kth/node/utility/announcement_ranking.hpp>
+#include <kth/node/utility/block_sizes.hpp>
+#include <kth/node/utility/block_tracker.hpp>
 #include <kth/node/utility/check_list.hpp>
+#include <kth/node/utility/hash_heights.hpp>
 #include <kth/node/utility/header_list.hpp>
+#include <kth/node/utility/import_queue.hpp>
 #include <kth/node/utility/performance.hpp>
 #include <kth/node/utility/reservation.hpp>
 #include <kth/node/utility/reservations.hpp>
+#include <kth/node/utility/short_id_table.hpp>
+#include <kth/node/utility/spill_file.hpp>
+#include <kth/node/utility/sync_state.hpp>
+#include <kth/node/utility/transaction_ring.hpp>
 
 #endif
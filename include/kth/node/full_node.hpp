@@ -40,7 +40,11 @@ class Table;
 #include <kth/node/sessions/session_header_sync.hpp>
 #endif
 
+#include <kth/node/utility/announcement_ranking.hpp>
+#include <kth/node/utility/block_tracker.hpp>
+#include <kth/node/utility/transaction_ring.hpp>
 #include <kth/node/utility/check_list.hpp>
+#include <kth/node/utility/sync_state.hpp>
 
 namespace kth::node {
 
@@ -194,6 +198,18 @@ public:
     virtual
     blockchain::block_chain& chain_kth();
 
+    /// Blocks requested by all channels.
+    virtual
+    block_tracker& tracker();
+
+    /// Channels ranked by first announcement of new blocks.
+    virtual
+    announcement_ranking& announcers();
+
+    /// Recent transactions not in the pool, for compact blocks.
+    virtual
+    transaction_ring& extra_transactions();
+
     // Subscriptions.
     // ------------------------------------------------------------------------
 
@@ -449,6 +465,7 @@ private:
 
 
     bool handle_reorganized(code ec, size_t fork_height, block_const_ptr_list_const_ptr incoming, block_const_ptr_list_const_ptr outgoing);
+    bool headers_first_sync() const;
     void handle_headers_synchronized(code const& ec, result_handler handler);
     void handle_network_stopped(code const& ec, result_handler handler);
 
@@ -510,6 +527,12 @@ private:
 
     // These are thread safe.
     check_list hashes_;
+    block_tracker tracker_;
+    announcement_ranking announcers_;
+    transaction_ring extra_transactions_;
+
+    // This is used sequentially by the sync sessions.
+    sync_state sync_state_;
     //blockchain::block_chain chain_;
 
 #if ! defined(__EMSCRIPTEN__)
@@ -5,10 +5,13 @@
 #ifndef KTH_NODE_PROTOCOL_BLOCK_IN_HPP
 #define KTH_NODE_PROTOCOL_BLOCK_IN_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
-#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <kth/blockchain.hpp>
 #if ! defined(__EMSCRIPTEN__)
 #include <kth/network.hpp>
@@ -36,7 +39,8 @@ public:
     virtual void start();
 
 private:
-    using hash_queue = std::queue<hash_digest>;
+    using hash_set = std::unordered_set<hash_digest>;
+    using held_blocks = std::unordered_multimap<hash_digest, block_const_ptr>;
 
 
 #if defined(KTH_STATISTICS_ENABLED)
@@ -49,6 +53,8 @@ private:
 
     void send_get_blocks(hash_digest const& stop_hash);
     void send_get_data(code const& ec, get_data_ptr message);
+    void send_request(get_data_ptr message);
+    void send_fallback(hash_digest const& hash);
 
     bool handle_receive_block(code const& ec, block_const_ptr message);
     bool handle_receive_compact_block(code const& ec, compact_block_const_ptr message);
@@ -62,10 +68,14 @@ private:
 
     void send_get_data_compact_block(code const& ec, hash_digest const& hash);
 
+    void announce(hash_digest const& hash);
+    void set_high_bandwidth();
+
     void handle_timeout(code const& ec);
     void handle_stop(code const& ec);
 
     void organize_block(block_const_ptr message);
+    void organize_held(hash_digest const& parent);
 
     // These are thread safe.
     full_node& node_;
@@ -76,12 +86,21 @@ private:
     bool const blocks_from_peer_;
 
     // This is protected by mutex.
-    hash_queue backlog_;
+    // Blocks requested and not received, blocks received and not stored, and
+    // received blocks held by the hash of a parent that is in either set.
+    hash_set in_flight_;
+    hash_set pending_;
+    held_blocks held_;
     mutable upgrade_mutex mutex;
 
+    // This is protected by compact blocks mutex.
+    // Handlers of different messages of a channel are not ordered, so the
+    // compact block and its block transactions may be handled concurrently.
     compact_block_map compact_blocks_map_;
+    mutable shared_mutex compact_blocks_mutex_;
 
-    bool compact_blocks_high_bandwidth_set_;
+    // Thread safe, set by the concurrent announcement handlers.
+    std::atomic<bool> compact_blocks_high_bandwidth_set_;
 
     // TODO(Mario): compact blocks version 1 hardcoded, change to 2 when segwit is implemented
 };
@@ -38,6 +38,7 @@ private:
     void handle_stop(code const&);
 
     // These are thread safe.
+    full_node& node_;
     blockchain::safe_chain& chain_;
     const uint64_t minimum_relay_fee_;
     bool const relay_from_peer_;
@@ -5,6 +5,7 @@
 #ifndef KTH_NODE_SESSION_BLOCK_SYNC_HPP
 #define KTH_NODE_SESSION_BLOCK_SYNC_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -23,6 +24,7 @@
 #include <kth/node/utility/check_list.hpp>
 #include <kth/node/utility/reservation.hpp>
 #include <kth/node/utility/reservations.hpp>
+#include <kth/node/utility/sync_state.hpp>
 
 namespace kth::node {
 
@@ -33,7 +35,7 @@ class BCN_API session_block_sync : public session<network::session_outbound>, tr
 public:
     using ptr = std::shared_ptr<session_block_sync>;
 
-    session_block_sync(full_node& network, check_list& hashes, blockchain::fast_chain& chain, settings const& settings);
+    session_block_sync(full_node& network, check_list& hashes, sync_state& state, blockchain::block_chain& chain, settings const& settings);
 
     void start(result_handler handler) override;
 
@@ -53,16 +55,27 @@ private:
     void handle_channel_start(code const& ec, network::channel::ptr channel, reservation::ptr row, result_handler handler);
     void handle_channel_complete(code const& ec, reservation::ptr row, result_handler handler);
     void handle_channel_stop(code const& ec, reservation::ptr row);
+    void handle_slot_complete(code const& ec, result_handler handler);
     void handle_complete(code const& ec, result_handler handler);
 
+    // Slots.
+    bool add_slot();
+
     // Timers.
     void reset_timer();
     void handle_timer(code const& ec);
 
     // These are thread safe.
-    blockchain::fast_chain& chain_;
+    blockchain::block_chain& chain_;
     reservations reservations_;
     deadline::ptr timer_;
+    std::atomic<size_t> slots_;
+
+    // Set on start, before the timer is started.
+    result_handler complete_;
+
+    // Used only on completion.
+    sync_state& state_;
 };
 
 } // namespace kth::node
@@ -5,6 +5,7 @@
 #ifndef KTH_NODE_SESSION_HEADER_SYNC_HPP
 #define KTH_NODE_SESSION_HEADER_SYNC_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -22,6 +23,7 @@
 #include <kth/node/settings.hpp>
 #include <kth/node/utility/check_list.hpp>
 #include <kth/node/utility/header_list.hpp>
+#include <kth/node/utility/sync_state.hpp>
 
 namespace kth::node {
 
@@ -32,7 +34,7 @@ class BCN_API session_header_sync : public session<network::session_outbound>, t
 public:
     using ptr = std::shared_ptr<session_header_sync>;
 
-    session_header_sync(full_node& network, check_list& hashes, blockchain::fast_chain& blockchain, infrastructure::config::checkpoint::list const& checkpoints);
+    session_header_sync(full_node& network, check_list& hashes, sync_state& state, blockchain::fast_chain& blockchain, infrastructure::config::checkpoint::list const& checkpoints, settings const& settings);
 
     virtual void start(result_handler handler) override;
 
@@ -47,6 +49,9 @@ private:
     using headers_table = std::vector<header_list::ptr>;
 
     bool initialize();
+    bool resume(infrastructure::config::checkpoint& start);
+    void partition(infrastructure::config::checkpoint const& start);
+    void enqueue(header_list::ptr row);
     void handle_started(code const& ec, result_handler handler);
     void new_connection(header_list::ptr row, result_handler handler);
     void start_syncing(code const& ec, infrastructure::config::authority const& host, result_handler handler);
@@ -58,12 +63,20 @@ private:
 
     // Thread safe.
     check_list& hashes_;
+    std::atomic<uint32_t> minimum_rate_;
 
     // These do not require guard because they are not used concurrently.
     headers_table headers_;
-    uint32_t minimum_rate_;
     blockchain::fast_chain& chain_;
     infrastructure::config::checkpoint::list const checkpoints_;
+    size_t const slots_;
+
+    // Protected by mutex.
+    sync_state& state_;
+    std::vector<bool> completed_;
+    size_t next_slot_;
+    bool persisted_;
+    mutable shared_mutex mutex_;
 };
 
 } // namespace kth::node
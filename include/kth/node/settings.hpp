@@ -20,7 +20,9 @@ public:
     /// Properties.
     uint32_t sync_peers;
     uint32_t sync_timeout_seconds;
+    uint32_t sync_memory_megabytes;
     uint32_t block_latency_seconds;
+    uint32_t block_race_peers;
     bool refresh_transactions;
     bool compact_blocks_high_bandwidth;
     bool ds_proofs_enabled;
@@ -0,0 +1,49 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_ANNOUNCEMENT_RANKING_HPP
+#define KTH_NODE_ANNOUNCEMENT_RANKING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <kth/domain.hpp>
+#include <kth/node/define.hpp>
+
+namespace kth::node {
+
+/// A thread safe node-wide ranking of channels by new block announcements.
+/// Each of the most recently announced blocks credits the channel that
+/// announced it first, and channels are ranked by their credits.
+class BCN_API announcement_ranking {
+public:
+    /// Construct a ranking of the top channels over the window of blocks.
+    announcement_ranking(size_t top, size_t window);
+
+    /// Record the announcement of the block by the channel.
+    /// Only the first channel to announce a block is credited.
+    void announce(hash_digest const& hash, uint64_t channel);
+
+    /// The channel has first announced a recent block and ranks in the top,
+    /// with ties broken in favor of the most recent announcement.
+    bool is_top(uint64_t channel) const;
+
+    /// The channel has stopped, its credits are dropped.
+    void remove(uint64_t channel);
+
+private:
+    using announcement = std::pair<hash_digest, uint64_t>;
+
+    size_t const top_;
+    size_t const window_;
+
+    // Protected by mutex, first announcements by increasing recency.
+    std::deque<announcement> firsts_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace kth::node
+
+#endif
@@ -0,0 +1,59 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_BLOCK_SIZES_HPP
+#define KTH_NODE_BLOCK_SIZES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <kth/domain.hpp>
+#include <kth/node/define.hpp>
+
+namespace kth::node {
+
+/// A thread safe estimator of serialized block size by height.
+/// Sizes are learned from imported blocks and averaged over height intervals.
+/// An interval without imported blocks takes the average of the highest
+/// interval recorded, as sizes change slowly with height.
+class BCN_API block_sizes {
+public:
+    /// The number of consecutive heights sharing an estimate.
+    static constexpr size_t interval = 1000;
+
+    /// Construct with the estimate used before any size is recorded.
+    explicit
+    block_sizes(uint64_t default_size);
+
+    /// Record the serialized size of the block at the height.
+    void record(size_t height, uint64_t size);
+
+    /// The estimated serialized size of the block at the height.
+    uint64_t estimate(size_t height) const;
+
+    /// The number of consecutive blocks from the first height estimated to
+    /// fit within bytes, at least one and at most maximum.
+    size_t count(size_t first, uint64_t bytes, size_t maximum) const;
+
+private:
+    struct bucket {
+        uint64_t bytes;
+        size_t count;
+    };
+
+    // The estimate for the height, mutex must be locked.
+    uint64_t get_estimate(size_t height) const;
+
+    uint64_t const default_size_;
+
+    // Protected by mutex.
+    std::vector<bucket> buckets_;
+    size_t latest_bucket_;
+    uint64_t latest_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace kth::node
+
+#endif
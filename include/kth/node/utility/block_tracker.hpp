@@ -0,0 +1,89 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_BLOCK_TRACKER_HPP
+#define KTH_NODE_BLOCK_TRACKER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <kth/domain.hpp>
+#include <kth/node/define.hpp>
+
+namespace kth::node {
+
+/// A thread safe node-wide record of requested blocks, by requesting channel.
+/// A block announced by several peers is requested from only one of them, or
+/// raced from as many as allowed. The others wait, and one of them requests
+/// the block if the requesting channels stop or the request is older than the
+/// timeout.
+class BCN_API block_tracker {
+public:
+    using clock = std::chrono::steady_clock;
+    using handler = std::function<void(hash_digest const&)>;
+
+    /// Construct a tracker in which requests expire after the timeout.
+    explicit
+    block_tracker(clock::duration timeout);
+
+    /// Virtual for testability.
+    virtual
+    ~block_tracker() = default;
+
+    /// The number of blocks tracked.
+    size_t size() const;
+
+    /// Track the request of the block by the channel, true if the channel
+    /// should request it now, as one of up to race channels. Otherwise the
+    /// channel waits for the block, and the handler is invoked if the channel
+    /// must request it after all.
+    bool request(hash_digest const& hash, uint64_t channel, handler fallback, size_t race=1);
+
+    /// The block has been received, stop tracking it.
+    void complete(hash_digest const& hash);
+
+    /// The channel has stopped. Requests left without a requesting channel
+    /// pass to a waiting channel.
+    void release(uint64_t channel);
+
+    /// Pass each request older than the timeout to a waiting channel.
+    void expire();
+
+protected:
+    // Isolation of side effect to enable unit testing.
+    virtual
+    clock::time_point now() const;
+
+private:
+    using waiter = std::pair<uint64_t, handler>;
+    using fallbacks = std::vector<std::pair<hash_digest, handler>>;
+
+    struct entry {
+        std::vector<uint64_t> channels;
+        clock::time_point requested;
+        std::vector<waiter> waiting;
+    };
+
+    // Add the first waiting channel to the request, mutex must be locked.
+    // Returns false if no channel is waiting.
+    bool reassign(hash_digest const& hash, entry& value, clock::time_point time, fallbacks& out);
+
+    // Invoke the handlers of reassigned requests, mutex must be unlocked.
+    static
+    void invoke(fallbacks const& reassigned);
+
+    clock::duration const timeout_;
+
+    // Protected by mutex.
+    std::unordered_map<hash_digest, entry> entries_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace kth::node
+
+#endif
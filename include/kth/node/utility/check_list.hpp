@@ -5,19 +5,25 @@
 #ifndef KTH_NODE_CHECK_LIST_HPP
 #define KTH_NODE_CHECK_LIST_HPP
 
+#include <array>
+#include <atomic>
 #include <cstddef>
-#include <boost/bimap.hpp>
-#include <boost/bimap/set_of.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
+#include <deque>
+#include <memory>
 #include <kth/database.hpp>
 #include <kth/node/define.hpp>
 
 namespace kth::node {
 
 /// A thread safe checkpoint queue.
+/// Heights are contiguous, so hashes are stored densely by height offset in
+/// a ring of fixed size chunks, without per entry allocation.
 class BCN_API check_list {
 public:
-    using heights = std::vector<size_t>;
+    using checks = infrastructure::config::checkpoint::list;
+
+    /// The number of hashes in a storage chunk.
+    static constexpr size_t chunk_size = 4096;
 
     /// The queue contains no checkpoints.
     bool empty() const;
@@ -25,22 +31,49 @@ public:
     /// The number of checkpoints in the queue.
     size_t size() const;
 
-    /// Reserve the entries indicated by the given heights.
+    /// The height of the next entry to be dequeued, if not empty.
+    size_t first() const;
+
+    /// Reserve the entries for the heights [first, last], in addition to
+    /// those already reserved. The range must start at the end of the
+    /// reserved range, or anywhere if the queue is empty.
     /// Any entry not reserved here will be ignored upon enqueue.
-    void reserve(const heights& heights);
+    bool reserve(size_t first, size_t last);
 
     /// Place a hash on the queue at the height if it has a reservation.
     void enqueue(hash_digest&& hash, size_t height);
 
+    /// Place consecutive hashes on the queue from the first height, ignoring
+    /// any that do not have a reservation.
+    void enqueue(hash_list const& hashes, size_t first_height);
+
     /// Remove the next entry by increasing height.
     bool dequeue(hash_digest& out_hash, size_t& out_height);
 
+    /// Remove up to count entries by increasing height, appending to out.
+    /// Returns the number of entries removed.
+    size_t dequeue_n(checks& out, size_t count);
+
 private:
-    // A bidirection map is used for efficient hash and height retrieval.
-    using checks = boost::bimaps::bimap<boost::bimaps::unordered_set_of<hash_digest>, boost::bimaps::set_of<size_t>> ;
+    using chunk = std::array<hash_digest, chunk_size>;
+    using chunk_ptr = std::unique_ptr<chunk>;
 
-    checks checks_;
+    // Get the storage for the reserved height.
+    hash_digest& at(size_t height);
+
+    // Release chunks that precede the first height.
+    void trim();
+
+    // Protected by mutex.
+    std::deque<chunk_ptr> chunks_;
+    chunk_ptr spare_;
+    size_t base_ = 0;
+    size_t first_ = 0;
+    size_t end_ = 0;
     mutable shared_mutex mutex_;
+
+    // Thread safe, allows empty and size without locking.
+    std::atomic<size_t> size_{0};
 };
 
 } // namespace kth::node
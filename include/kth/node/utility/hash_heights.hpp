@@ -0,0 +1,125 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_HASH_HEIGHTS_HPP
+#define KTH_NODE_HASH_HEIGHTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <kth/domain.hpp>
+#include <kth/node/define.hpp>
+
+namespace kth::node {
+
+/// A height ordered set of block hashes with lookup by hash, not thread safe.
+/// Entries are held in a contiguous array sorted by height, indexed by an
+/// open addressing table from hash to array position. Erasure leaves a
+/// tombstone in both, which is reclaimed when the array is compacted.
+class BCN_API hash_heights {
+public:
+    struct entry {
+        hash_digest hash;
+        size_t height;
+        bool erased;
+        bool requested;
+    };
+
+    /// There are no entries.
+    bool empty() const;
+
+    /// The number of entries.
+    size_t size() const;
+
+    /// The number of entries marked as requested.
+    size_t requested() const;
+
+    /// Mark all entries as not requested.
+    void reset_requested();
+
+    /// Remove all entries.
+    void clear();
+
+    /// Add the hash at the height, the hash must not be present.
+    void insert(hash_digest const& hash, size_t height);
+
+    /// Get the height of the hash, remove and return true if it is found.
+    bool find_and_erase(hash_digest const& hash, size_t& out_height);
+
+    /// Replace out with the count highest entries, moved as a single range.
+    /// The moved entries are not requested. Returns the number moved.
+    size_t move_back(hash_heights& out, size_t count);
+
+    /// Invoke handler(hash, height) for each entry, by increasing height.
+    template <typename Handler>
+    void for_each(Handler&& handler) const {
+        for (auto it = entries_.begin() + front_; it != entries_.end(); ++it) {
+            if ( ! it->erased) {
+                handler(it->hash, it->height);
+            }
+        }
+    }
+
+    /// Invoke handler(hash, height) for up to count of the lowest entries.
+    template <typename Handler>
+    void front(size_t count, Handler&& handler) const {
+        for (auto it = entries_.begin() + front_; it != entries_.end() && count != 0; ++it) {
+            if ( ! it->erased) {
+                handler(it->hash, it->height);
+                --count;
+            }
+        }
+    }
+
+    /// Mark up to count of the lowest entries not yet requested as requested,
+    /// invoking handler(hash, height) for each. Returns the number marked.
+    template <typename Handler>
+    size_t request(size_t count, Handler&& handler) {
+        size_t marked = 0;
+
+        for (auto it = entries_.begin() + front_; it != entries_.end() && marked < count; ++it) {
+            if ( ! it->erased && ! it->requested) {
+                it->requested = true;
+                handler(it->hash, it->height);
+                ++marked;
+            }
+        }
+
+        requested_ += marked;
+        return marked;
+    }
+
+private:
+    using slot = uint32_t;
+    using index = std::vector<slot>;
+    static constexpr slot empty_slot = max_uint32;
+    static constexpr slot tombstone = max_uint32 - 1;
+
+    // The index bucket of the hash, for the given index capacity.
+    static
+    size_t bucket(hash_digest const& hash, size_t capacity);
+
+    // Find the index slot holding the position of the hash, or capacity.
+    size_t find(hash_digest const& hash) const;
+
+    // Add the entry position to the index, growing the index as required.
+    void add(size_t position);
+
+    // Remove erased entries and rebuild the index.
+    void compact();
+
+    // Rebuild the index from the entries, with at least the given capacity.
+    void rebuild(size_t capacity);
+
+    std::vector<entry> entries_;
+    index index_;
+    size_t front_ = 0;
+    size_t size_ = 0;
+    size_t used_ = 0;
+    size_t requested_ = 0;
+};
+
+} // namespace kth::node
+
+#endif
@@ -23,9 +23,18 @@ public:
     /// Construct a list to fill the specified range of headers.
     header_list(size_t slot, infrastructure::config::checkpoint const& start, infrastructure::config::checkpoint const& stop);
 
+    /// Construct a tail list to fill headers above start, up to a target.
+    header_list(size_t slot, infrastructure::config::checkpoint const& start);
+
     /// The list is fully populated.
     bool complete() const;
 
+    /// The list is not terminated by a checkpoint.
+    bool tail() const;
+
+    /// Set the height at which a tail list is complete (the peer's top).
+    void set_target(size_t height);
+
     /// The slot id of this instance.
     size_t slot() const;
 
@@ -38,7 +47,7 @@ public:
     /// The hash of the last header in the list (or the start hash).
     hash_digest previous_hash() const;
 
-    /// The hash of the stop checkpoint.
+    /// The hash of the stop checkpoint (null for a tail).
     hash_digest const& stop_hash() const;
 
     /// The ordered list of headers.
@@ -70,6 +79,7 @@ private:
 
     // This is protected by mutex.
     domain::chain::header::list list_;
+    size_t target_;
 
 #if ! defined(__EMSCRIPTEN__)
     mutable upgrade_mutex mutex_;
@@ -81,6 +91,7 @@ private:
     infrastructure::config::checkpoint const start_;
     infrastructure::config::checkpoint const stop_;
     size_t const slot_;
+    bool const tail_;
 };
 
 } // namespace kth::node
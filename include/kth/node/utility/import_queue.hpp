@@ -0,0 +1,148 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_IMPORT_QUEUE_HPP
+#define KTH_NODE_IMPORT_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <kth/blockchain.hpp>
+#include <kth/node/define.hpp>
+
+namespace kth::node {
+
+class reservation;
+
+/// A thread safe queue of downloaded blocks awaiting import, by height.
+/// The queue accepts every block pushed while started, as blocks already
+/// requested must be retained, and reports full so that further requests
+/// can be deferred until the importer catches up. Only the block at the
+/// import cursor may be popped, and the cursor advances as each block is
+/// reported imported, so blocks are imported strictly in height order.
+/// If checks are required, a block is not popped until it has been
+/// reported checked.
+/// Blocks above the cursor may be held spilled, by a location in external
+/// storage, so that the blocks held in memory remain within a budget. A
+/// spilled block is taken for check once it fits the budget or is at the
+/// cursor, and is loaded by the checker.
+class BCN_API import_queue {
+public:
+    struct entry {
+        block_const_ptr block;
+        size_t height;
+        std::shared_ptr<reservation> row;
+        bool prefetched = false;
+        bool checking = false;
+        bool checked = false;
+        bool spilled = false;
+        hash_digest hash = null_hash;
+        uint64_t size = 0;
+        uint64_t offset = 0;
+    };
+
+    using list = std::vector<entry>;
+
+    /// Construct a queue that reports full at the specified size, optionally
+    /// requiring each block to be checked before it may be popped, and
+    /// holding blocks in memory up to the specified bytes.
+    explicit
+    import_queue(size_t capacity, bool require_checks = false, uint64_t memory = max_uint64);
+
+    /// The queue contains no blocks.
+    bool empty() const;
+
+    /// The number of blocks in the queue.
+    size_t size() const;
+
+    /// The queue is at or above capacity.
+    bool full() const;
+
+    /// The serialized bytes of the blocks held in memory.
+    uint64_t memory() const;
+
+    /// The block at the height would exceed the memory budget and is not
+    /// at the import cursor, so it should be pushed spilled.
+    bool spill(size_t height, uint64_t size) const;
+
+    /// Accept blocks, with the import cursor at the height.
+    /// Return false if the queue is already started.
+    bool start(size_t height);
+
+    /// Stop accepting blocks, queued blocks remain available to pop.
+    void stop();
+
+    /// Add the block at the height, return false if stopped, duplicated or
+    /// below the import cursor.
+    bool push(block_const_ptr block, size_t height, std::shared_ptr<reservation> row);
+
+    /// Add the spilled block of the hash and size, stored at the offset.
+    /// A spilled block is popped only once checked, so requires checks.
+    /// Returns false if stopped, duplicated or below the import cursor.
+    bool push(hash_digest const& hash, size_t height, uint64_t size, uint64_t offset, std::shared_ptr<reservation> row);
+
+    /// Wait for and remove the block at the import cursor. A missing or
+    /// unchecked block at the cursor holds back those above it.
+    /// Returns false when stopped and the cursor block is not queued.
+    bool pop(entry& out_entry);
+
+    /// Advance the import cursor above the height of an imported block.
+    void imported(size_t height);
+
+    /// Wait for any of the lowest count blocks not yet prefetched and not
+    /// spilled, marking them prefetched and appending copies to out.
+    /// Returns false when stopped.
+    bool prefetch(list& out, size_t count);
+
+    /// Wait for the lowest block not yet checked or being checked, marking
+    /// it as being checked and copying it to out. A spilled block is taken
+    /// when it is at the cursor or fits the memory budget, and must be loaded.
+    /// Returns false when stopped and no block remains to be checked, or
+    /// once pop has failed, as no further block can then be imported.
+    bool check(entry& out_entry);
+
+    /// Report the result of checking the block at the height, an invalid
+    /// block is removed from the queue. A loaded block replaces its spill.
+    void checked(size_t height, bool valid, block_const_ptr loaded = nullptr);
+
+private:
+    // There is a block to prefetch in the lowest count, mutex must be locked.
+    bool prefetchable(size_t count) const;
+
+    // The block at the import cursor is queued, mutex must be locked.
+    bool queued() const;
+
+    // The block at the import cursor may be popped, mutex must be locked.
+    bool poppable() const;
+
+    // A block is neither checked nor being checked, mutex must be locked.
+    bool unchecked() const;
+
+    // The first block neither checked nor being checked, mutex must be locked.
+    std::map<size_t, entry>::iterator next_unchecked();
+
+    // Remove the entry, mutex must be locked.
+    std::map<size_t, entry>::iterator erase(std::map<size_t, entry>::iterator it);
+
+    size_t const capacity_;
+    bool const require_checks_;
+    uint64_t const memory_limit_;
+
+    // Protected by mutex.
+    bool stopped_;
+    bool drained_;
+    size_t cursor_;
+    uint64_t memory_;
+    std::map<size_t, entry> entries_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+};
+
+} // namespace kth::node
+
+#endif
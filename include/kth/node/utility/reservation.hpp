@@ -10,11 +10,9 @@
 #include <cstdint>
 #include <memory>
 #include <vector>
-#include <boost/bimap.hpp>
-#include <boost/bimap/set_of.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
 #include <kth/blockchain.hpp>
 #include <kth/node/define.hpp>
+#include <kth/node/utility/hash_heights.hpp>
 #include <kth/node/utility/performance.hpp>
 
 namespace kth::node {
@@ -45,6 +43,12 @@ public:
     /// The reservation is empty and will remain so.
     bool stopped() const;
 
+    /// The reservation will not be populated once empty.
+    bool retired() const;
+
+    /// Stop populating the reservation, allowing it to complete its hashes.
+    void retire();
+
     /// True if block import rate was more than one standard deviation low.
     bool expired() const;
 
@@ -60,7 +64,8 @@ public:
     /// The current cached average block import rate excluding import time.
     void set_rate(performance&& rate);
 
-    /// The block data request message for the outstanding block hashes.
+    /// The block data request message for the next window of outstanding
+    /// block hashes, empty if more than half of the window is in flight.
     /// Set new if the preceding request was unsuccessful or discarded.
     domain::message::get_data request(bool new_channel);
 
@@ -68,14 +73,22 @@ public:
     void insert(hash_digest&& hash, size_t height);
 
 #if ! defined(KTH_DB_READONLY)
-    /// Add to the blockchain, with height determined by the reservation.
+    /// Queue for import, with height determined by the reservation.
     void import(block_const_ptr block);
+
+    /// Add to the blockchain at the height, called by the importer.
+    /// Returns false if the block was not stored.
+    bool store(block_const_ptr block, size_t height);
 #endif
 
-    /// Determine if the reservation was partitioned and reset partition flag.
-    bool toggle_partitioned();
+    /// Get the height of the block hash, remove and return true if it is found.
+    bool find_height_and_erase(hash_digest const& hash, size_t& out_height);
 
-    /// Move half of the reservation to the specified reservation.
+    /// Append up to count of the lowest outstanding hashes to out.
+    void lowest(size_t count, infrastructure::config::checkpoint::list& out) const;
+
+    /// Move the upper half of the reservation by estimated bytes to the
+    /// specified reservation.
     bool partition(reservation::ptr minimal);
 
     /// If not stopped and if empty try to get more hashes.
@@ -104,14 +117,18 @@ private:
 
     using rate_history = std::vector<import_record>;
 
-    // A bidirection map is used for efficient hash and height retrieval.
-    using hash_heights = boost::bimaps::bimap<boost::bimaps::unordered_set_of<hash_digest>, boost::bimaps::set_of<size_t>>;
+    // The number of blocks to keep in flight from the height, based on the
+    // current rate.
+    size_t window(size_t height) const;
 
     // Return rate history to startup state.
     void clear_history();
 
-    // Get the height of the block hash, remove and return true if it is found.
-    bool find_height_and_erase(hash_digest const& hash, size_t& out_height);
+    // Remove the oldest record from the rate history.
+    void pop_history();
+
+    // Merge the hashes into the reservation, which is usually empty.
+    void insert(hash_heights&& heights);
 
     // Update rate history to reflect an additional block of the given size.
     void update_rate(size_t events, const std::chrono::microseconds& database);
@@ -127,7 +144,12 @@ private:
 
 
     // Protected by history mutex.
+    // A fixed size ring buffer with running totals of the held records.
     rate_history history_;
+    size_t history_first_;
+    size_t history_count_;
+    size_t history_events_;
+    uint64_t history_database_;
 #if ! defined(__EMSCRIPTEN__)
     mutable upgrade_mutex history_mutex_;
 #else
@@ -137,6 +159,7 @@ private:
 
     // Protected by stop mutex.
     bool stopped_;
+    bool retired_;
 #if ! defined(__EMSCRIPTEN__)
     mutable upgrade_mutex stop_mutex_;
 #else
@@ -146,7 +169,6 @@ private:
 
     // Protected by hash mutex.
     bool pending_;
-    bool partitioned_;
     hash_heights heights_;
 #if ! defined(__EMSCRIPTEN__)
     mutable upgrade_mutex hash_mutex_;
@@ -6,15 +6,22 @@
 #define KTH_NODE_RESERVATIONS_HPP
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 #include <kth/blockchain.hpp>
 #include <kth/node/define.hpp>
 #include <kth/node/settings.hpp>
+#include <kth/node/utility/block_sizes.hpp>
 #include <kth/node/utility/check_list.hpp>
+#include <kth/node/utility/import_queue.hpp>
 #include <kth/node/utility/reservation.hpp>
+#include <kth/node/utility/spill_file.hpp>
+#include <kth/node/utility/sync_state.hpp>
 
 namespace kth::node {
 
@@ -31,31 +38,76 @@ public:
 
     /// Construct a reservation table of reservations, allocating hashes evenly
     /// among the rows up to the limit of a single get headers p2p request.
-    reservations(check_list& hashes, blockchain::fast_chain& chain, settings const& settings);
+    /// The import height is recorded to the state as blocks are imported.
+    /// Blocks above the last checkpoint of the chain are organized.
+    reservations(check_list& hashes, sync_state& state, blockchain::block_chain& chain, settings const& settings);
 
-    /// Set the flush lock guard.
+    /// Stop the importer, if started.
+    ~reservations();
+
+    /// Start the importer, prefetcher and checker threads.
     bool start();
 
-    /// Clear the flush lock guard.
+    /// Stop the threads once queued blocks have been checked and imported.
+    /// Returns false if the import stopped at a checkpointed block that failed
+    /// to store, or at a height for which no valid block could be obtained.
+    /// A block rejected above the last checkpoint stops the import without
+    /// failing it, the blocks above it are left to the block protocols.
     bool stop();
 
     /// The average and standard deviation of block import rates.
     rate_statistics rates() const;
 
+    /// Replace the contribution of a row's rate to the rate statistics.
+    /// Idle rates do not contribute.
+    void update_rates(performance const& previous, performance const& current);
+
     /// Return a copy of the reservation table.
     reservation::list table() const;
 
 #if ! defined(KTH_DB_READONLY)
     /// Import the given block to the blockchain at the specified height.
+    /// A block above the last checkpoint is fully validated by organize.
     bool import(block_const_ptr block, size_t height);
+
+    /// Queue the block for import by the importer on behalf of the row.
+    bool enqueue(block_const_ptr block, size_t height, reservation::ptr row);
 #endif
 
+    /// The estimated serialized size of the block at the height.
+    uint64_t estimate(size_t height) const;
+
+    /// The fraction of prefetched previous outputs found in the store.
+    double prefetch_hit_rate() const;
+
+    /// The import queue is full, further block requests should be deferred.
+    bool saturated() const;
+
     /// Populate a starved row by taking half of the hashes from a weak row.
     bool populate(reservation::ptr minimal);
 
+    /// Remove the block hash from any row, setting its height if found.
+    bool find_height_and_erase(hash_digest const& hash, size_t& out_height);
+
+    /// Remove any duplicated request for the block hash from all rows.
+    /// Only hashes duplicated to another row are searched for.
+    void cancel(hash_digest const& hash);
+
     /// Remove the row from the reservation table if found.
     void remove(reservation::ptr row);
 
+    /// Compare aggregate import throughput with that of the last call,
+    /// retiring the slowest row if the last added row did not improve it.
+    /// Expedites the lowest outstanding blocks if the import has stalled.
+    /// Returns true if a row should be added. Call sequentially.
+    bool regulate();
+
+    /// Add and populate a new row, or return nullptr if there are no hashes.
+    reservation::ptr add();
+
+    /// The maximum estimated bytes of a reservation.
+    uint64_t max_bytes() const;
+
     /// The max size of a block request.
     size_t max_request() const;
 
@@ -65,25 +117,105 @@ public:
 private:
     bool inline flush(size_t height);
 
+#if ! defined(KTH_DB_READONLY)
+    // Organize the block and wait for the result of its validation.
+    bool organize(block_const_ptr block, size_t height);
+#endif
+
+    // Import queued blocks until the queue is stopped and empty.
+    void drain();
+
+    // Check queued blocks independently of the chain state, in parallel.
+    void check();
+    bool check(domain::chain::block const& block) const;
+
+    // Parse the spilled block of the entry from the spill file.
+    block_const_ptr load(import_queue::entry const& entry) const;
+
+    // Reserve the hash of an invalid block again, preferring the given row.
+    void restore(hash_digest&& hash, size_t height, reservation::ptr row);
+
+    // Read the previous outputs of queued blocks ahead of their import.
+    void prefetch();
+    void prefetch(domain::chain::block const& block, size_t height);
+
     // Create the specified number of reservations and distribute hashes.
     void initialize(size_t connections);
 
     // Find the reservation with the most hashes.
-    reservation::ptr find_maximal();
+    reservation::ptr find_maximal() const;
 
-    // Move half of the maximal reservation to the specified reservation.
+    // Move the upper half of the maximal reservation to the specified one.
     bool partition(reservation::ptr minimal);
 
     // Move the maximum unreserved hashes to the specified reservation.
     bool reserve(reservation::ptr minimal);
 
+    // Duplicate the lowest outstanding hashes of other rows to the minimal.
+    bool endgame(reservation::ptr minimal);
+
+    // Duplicate the lowest outstanding hashes to the fastest other row.
+    void expedite();
+
+    // Retire the active row with the lowest rate, leaving at least one.
+    void retire_slowest();
+
+    // Add or remove a normal rate from the running statistics.
+    void add_rate(double rate);
+    void remove_rate(double rate);
+
     // Thread safe.
     check_list& hashes_;
+    block_sizes sizes_;
     std::atomic<size_t> max_request_;
+    std::atomic<size_t> next_slot_;
+    std::atomic<uint64_t> imported_bytes_;
+    std::atomic<bool> failed_;
+    std::atomic<bool> rejected_;
     const uint32_t timeout_;
+    const size_t maximum_rows_;
+    const uint64_t memory_;
+    const size_t first_;
+    const size_t checkpoint_;
+
+    // Protected by regulator sequence.
+    std::chrono::steady_clock::time_point regulated_;
+    uint64_t regulated_imported_;
+    double regulated_rate_;
+    size_t backoff_;
+    size_t stalled_;
+    bool added_;
 
     // Protected by block exclusivity and limited call scope.
-    blockchain::fast_chain& chain_;
+    blockchain::block_chain& chain_;
+
+    // The importer is its only user during block sync.
+    sync_state& state_;
+
+    // Thread safe, the importer is the only caller of chain insert.
+    import_queue queue_;
+    std::thread importer_;
+    std::thread prefetcher_;
+    std::vector<std::thread> checkers_;
+    spill_file spill_;
+    std::atomic<uint64_t> prefetched_;
+    std::atomic<uint64_t> prefetch_hits_;
+
+    // Protected by duplicates mutex.
+    // The hashes held by more than one row, until the first copy is imported.
+    std::unordered_set<hash_digest> duplicates_;
+    mutable shared_mutex duplicates_mutex_;
+
+    // Protected by rates mutex.
+    size_t rates_count_;
+    double rates_mean_;
+    double rates_squares_;
+    mutable shared_mutex rates_mutex_;
+
+    // Thread safe, allows rates without locking.
+    std::atomic<size_t> active_count_;
+    std::atomic<double> arithmetic_mean_;
+    std::atomic<double> standard_deviation_;
 
     // Protected by mutex.
     reservation::list table_;
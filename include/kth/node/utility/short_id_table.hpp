@@ -0,0 +1,65 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_SHORT_ID_TABLE_HPP
+#define KTH_NODE_SHORT_ID_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <kth/domain.hpp>
+#include <kth/node/define.hpp>
+
+namespace kth::node {
+
+/// A flat open addressing table of the short ids of a compact block (BIP152)
+/// by transaction position, with the SipHash-2-4 short id computation.
+/// This class is not thread safe.
+class BCN_API short_id_table {
+public:
+    /// The SipHash-2-4 key of the short ids of a compact block.
+    struct key {
+        uint64_t k0;
+        uint64_t k1;
+    };
+
+    /// The key derived from the compact block header and nonce.
+    static
+    key make_key(domain::chain::header const& header, uint64_t nonce);
+
+    /// The 48 bit short id of the transaction hash.
+    static
+    uint64_t short_id(key const& key, hash_digest const& hash);
+
+    /// The 48 bit short ids of count contiguous transaction hashes.
+    static
+    void short_ids(key const& key, hash_digest const* hashes, size_t count, uint64_t* out);
+
+    /// Construct a table for up to count short ids.
+    explicit
+    short_id_table(size_t count);
+
+    /// The number of short ids in the table.
+    size_t size() const;
+
+    /// Add the short id at the transaction position, false if it is present.
+    /// Also false if the ids are too unevenly distributed to place it, in
+    /// which case the table should not be used.
+    bool insert(uint64_t short_id, uint16_t index);
+
+    /// Find the transaction position of the short id.
+    bool find(uint64_t short_id, uint16_t& out_index) const;
+
+private:
+    size_t slot(uint64_t short_id) const;
+
+    size_t const mask_;
+    size_t size_;
+    std::vector<uint64_t> ids_;
+    std::vector<uint16_t> indexes_;
+};
+
+} // namespace kth::node
+
+#endif
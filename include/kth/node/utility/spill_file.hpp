@@ -0,0 +1,87 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_SPILL_FILE_HPP
+#define KTH_NODE_SPILL_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <kth/domain.hpp>
+#include <kth/node/define.hpp>
+
+namespace kth::node {
+
+/// A thread safe temporary store of byte ranges in a memory mapped file.
+/// Released ranges are reused, and the file is removed when closed.
+class BCN_API spill_file {
+public:
+    /// Construct a store for the file at the path, which is not created.
+    explicit
+    spill_file(std::filesystem::path const& path);
+
+    /// Close the store, if open.
+    ~spill_file();
+
+    /// Create the file, replacing any existing, false if already open.
+    bool open();
+
+    /// Unmap and remove the file, all ranges are discarded.
+    void close();
+
+    /// The number of stored bytes not yet released.
+    uint64_t size() const;
+
+    /// Copy the data to the file, setting the offset of the stored range.
+    /// Returns false if the store is closed or the file cannot be grown.
+    bool store(data_chunk const& data, uint64_t& out_offset);
+
+    /// Invoke the handler with a pointer to the stored range in the mapped
+    /// file, which remains valid only for the duration of the call.
+    /// Returns false if the store is closed or the range is not mapped.
+    template <typename Handler>
+    bool load(uint64_t offset, uint64_t size, Handler handler) const {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        shared_lock lock(mutex_);
+
+        if ( ! region_ || offset + size > end_) {
+            return false;
+        }
+
+        auto const data = static_cast<uint8_t const*>(region_->get_address());
+        handler(data + offset, static_cast<size_t>(size));
+        return true;
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    /// Release the stored range for reuse.
+    void release(uint64_t offset, uint64_t size);
+
+private:
+    // Map the file at the capacity, mutex must be locked.
+    bool map(uint64_t capacity);
+
+    // Find or create space for the size, mutex must be locked.
+    bool allocate(uint64_t size, uint64_t& out_offset);
+
+    std::filesystem::path const path_;
+
+    // Protected by mutex.
+    // Free ranges are coalesced, keyed by offset below the end of use.
+    std::map<uint64_t, uint64_t> free_;
+    std::unique_ptr<boost::interprocess::mapped_region> region_;
+    uint64_t capacity_;
+    uint64_t end_;
+    uint64_t size_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace kth::node
+
+#endif
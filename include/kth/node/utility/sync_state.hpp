@@ -0,0 +1,63 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_SYNC_STATE_HPP
+#define KTH_NODE_SYNC_STATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <kth/domain.hpp>
+#include <kth/node/define.hpp>
+
+namespace kth::node {
+
+/// A file of the headers obtained by headers-first sync, so that a restarted
+/// sync resumes from them instead of downloading the headers again.
+/// Headers are appended in height order as header slots are enqueued, and
+/// the height of the next block to import is updated as blocks are imported.
+/// The file is a magic number, the height of the first header and the import
+/// height, followed by serialized headers. Not thread safe.
+class BCN_API sync_state {
+public:
+    /// Construct a state for the file at the path, which is not read.
+    explicit
+    sync_state(std::filesystem::path const& path);
+
+    /// Read the linked headers of the file and the height of the first,
+    /// continuing appends from them. Any partial or unlinked headers are
+    /// removed. Returns false if the file is missing or malformed.
+    bool open(size_t& out_first_height, domain::chain::header::list& out_headers);
+
+    /// Replace the file with one to hold headers from the height, which is
+    /// also the import height.
+    bool create(size_t first_height);
+
+    /// Append headers starting at the height, false if it does not continue
+    /// the file or the file is not open.
+    bool append(domain::chain::header::list const& headers, size_t first_height);
+
+    /// The height of the next header to append, if open.
+    size_t next_height() const;
+
+    /// The height of the next block to import, if open. All blocks below it
+    /// are imported, but blocks may have been imported above it since.
+    size_t import_height() const;
+
+    /// Record the height of the next block to import, false if not open.
+    bool set_import_height(size_t height);
+
+    /// Remove the file, further appends fail.
+    void remove();
+
+private:
+    std::filesystem::path const path_;
+    bool open_;
+    size_t next_;
+    size_t import_;
+};
+
+} // namespace kth::node
+
+#endif
@@ -0,0 +1,48 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KTH_NODE_TRANSACTION_RING_HPP
+#define KTH_NODE_TRANSACTION_RING_HPP
+
+#include <cstddef>
+#include <vector>
+#include <kth/domain.hpp>
+#include <kth/node/define.hpp>
+#include <kth/node/utility/short_id_table.hpp>
+
+namespace kth::node {
+
+/// A thread safe ring of recently seen transactions that are not in the
+/// memory pool, such as orphans and transactions rejected for policy.
+/// Compact blocks may still contain them, so they are matched by short id
+/// when a block is reconstructed, avoiding a transaction request.
+class BCN_API transaction_ring {
+public:
+    /// Construct a ring of the capacity, the oldest transaction is replaced.
+    explicit
+    transaction_ring(size_t capacity);
+
+    /// The number of transactions in the ring.
+    size_t size() const;
+
+    /// Add the transaction, replacing the oldest if the ring is full.
+    void store(transaction_const_ptr transaction);
+
+    /// Place each transaction whose short id is in the table at its position
+    /// in out, if that position has no valid transaction.
+    /// Returns the number of transactions placed.
+    size_t fill(short_id_table::key const& key, short_id_table const& table, std::vector<domain::chain::transaction>& out) const;
+
+private:
+    size_t const capacity_;
+
+    // Protected by mutex.
+    size_t next_;
+    std::vector<transaction_const_ptr> ring_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace kth::node
+
+#endif
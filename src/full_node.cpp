@@ -4,6 +4,7 @@
 
 #include <kth/node/full_node.hpp>
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -49,6 +50,22 @@ using namespace kth::network;
 
 using namespace std::placeholders;
 
+// The file of headers persisted by headers-first sync, in the database directory.
+static constexpr auto sync_state_file = "sync_state";
+
+// The time after which a block requested from one peer may be requested from
+// another that announced it.
+static constexpr auto block_request_timeout = std::chrono::seconds(10);
+
+// The number of peers in compact block high-bandwidth mode (BIP152 limit).
+static constexpr size_t high_bandwidth_peers = 3;
+
+// The number of recent blocks over which first announcements are ranked.
+static constexpr size_t announcement_window = 16;
+
+// The number of recently rejected transactions kept for compact blocks.
+static constexpr size_t extra_transactions_capacity = 100;
+
 full_node::full_node(configuration const& configuration)
 #if ! defined(__EMSCRIPTEN__)
     : multi_crypto_setter(configuration.network)
@@ -74,6 +91,11 @@ full_node::full_node(configuration const& configuration)
     )
 #endif
 
+    , tracker_(block_request_timeout)
+    , announcers_(high_bandwidth_peers, announcement_window)
+    , extra_transactions_(extra_transactions_capacity)
+    , sync_state_(configuration.database.directory / sync_state_file)
+
 #if ! defined(__EMSCRIPTEN__)
     , protocol_maximum_(configuration.network.protocol_maximum)
 #endif
@@ -136,27 +158,24 @@ void full_node::run(result_handler handler) {
         return;
     }
 
-    // Skip sync sessions.
-    handle_running(error::success, handler);
-    return;
+    // By setting no download connections checkpoints can be used without sync.
+    // This also allows the maximum protocol version to be set below headers.
+    if ( ! headers_first_sync()) {
+        // Skip sync sessions.
+        handle_running(error::success, handler);
+        return;
+    }
 
-    // TODO: make this safe by requiring sync if gaps found.
-    ////// By setting no download connections checkpoints can be used without sync.
-    ////// This also allows the maximum protocol version to be set below headers.
-    ////if (settings_.sync_peers == 0)
-    ////{
-    ////    // This will spawn a new thread before returning.
-    ////    handle_running(error::success, handler);
-    ////    return;
-    ////}
+    LOG_INFO(LOG_NODE, "Starting headers-first sync with up to ("
+       , node_settings_.sync_peers, ") peers.");
 
-    ////// The instance is retained by the stop handler (i.e. until shutdown).
-    ////auto const header_sync = attach_header_sync_session();
+    // The instance is retained by the stop handler (i.e. until shutdown).
+    auto const header_sync = attach_header_sync_session();
 
-    ////// This is invoked on a new thread.
-    ////header_sync->start(
-    ////    std::bind(&full_node::handle_headers_synchronized,
-    ////        this, _1, handler));
+    // This is invoked on a new thread.
+    header_sync->start(
+        std::bind(&full_node::handle_headers_synchronized,
+            this, _1, handler));
 }
 
 void full_node::run_chain(result_handler handler) {
@@ -171,27 +190,34 @@ void full_node::run_chain(result_handler handler) {
 }
 
 void full_node::handle_headers_synchronized(code const& ec, result_handler handler) {
-    ////if (stopped())
-    ////{
-    ////    handler(error::service_stopped);
-    ////    return;
-    ////}
+    if (stopped()) {
+        handler(error::service_stopped);
+        return;
+    }
 
-    ////if (ec)
-    ////{
-    ////    LOG_ERROR(LOG_NODE
-    ////       , "Failure synchronizing headers: ", ec.message());
-    ////    handler(ec);
-    ////    return;
-    ////}
+    if (ec) {
+        LOG_ERROR(LOG_NODE, "Failure synchronizing headers: ", ec.message());
+        handler(ec);
+        return;
+    }
 
-    ////// The instance is retained by the stop handler (i.e. until shutdown).
-    ////auto const block_sync = attach_block_sync_session();
+    // The instance is retained by the stop handler (i.e. until shutdown).
+    auto const block_sync = attach_block_sync_session();
 
-    ////// This is invoked on a new thread.
-    ////block_sync->start(
-    ////    std::bind(&full_node::handle_running,
-    ////        this, _1, handler));
+    // This is invoked on a new thread.
+    block_sync->start(
+        std::bind(&full_node::handle_running,
+            this, _1, handler));
+}
+
+// Headers-first sync requires sync peers, the headers message and a writer.
+bool full_node::headers_first_sync() const {
+#if defined(KTH_DB_READONLY)
+    return false;
+#else
+    return node_settings_.sync_peers != 0 &&
+        protocol_maximum_ >= domain::message::version::level::headers;
+#endif
 }
 
 void full_node::handle_running(code const& ec, result_handler handler) {
@@ -311,11 +337,11 @@ kth::network::session_outbound::ptr full_node::attach_outbound_session() {
 }
 
 session_header_sync::ptr full_node::attach_header_sync_session() {
-    return attach<session_header_sync>(hashes_, chain_, chain_.chain_settings().checkpoints);
+    return attach<session_header_sync>(hashes_, sync_state_, chain_, chain_.chain_settings().checkpoints, node_settings_);
 }
 
 session_block_sync::ptr full_node::attach_block_sync_session() {
-    return attach<session_block_sync>(hashes_, chain_, node_settings_);
+    return attach<session_block_sync>(hashes_, sync_state_, chain_, node_settings_);
 }
 #endif
 
@@ -379,6 +405,18 @@ block_chain& full_node::chain_kth() {
     return chain_;
 }
 
+block_tracker& full_node::tracker() {
+    return tracker_;
+}
+
+announcement_ranking& full_node::announcers() {
+    return announcers_;
+}
+
+transaction_ring& full_node::extra_transactions() {
+    return extra_transactions_;
+}
+
 // Subscriptions.
 // ----------------------------------------------------------------------------
 
@@ -508,20 +508,26 @@ options_metadata parser::load_settings() {
 
 
     /* [node] */
-    ////(
-    ////    "node.sync_peers",
-    ////    value<uint32_t>(&configured.node.sync_peers),
-    ////    "The maximum number of initial block download peers, defaults to 0 (physical cores)."
-    ////)
-    ////(
-    ////    "node.sync_timeout_seconds",
-    ////    value<uint32_t>(&configured.node.sync_timeout_seconds),
-    ////    "The time limit for block response during initial block download, defaults to 5."
-    ////)
     (
+        "node.sync_peers",
+        value<uint32_t>(&configured.node.sync_peers),
+        "The maximum number of headers-first initial block download peers, defaults to 0 (headers-first sync disabled)."
+    )(
+        "node.sync_timeout_seconds",
+        value<uint32_t>(&configured.node.sync_timeout_seconds),
+        "The time limit for block response during initial block download, defaults to 5."
+    )(
+        "node.sync_memory_megabytes",
+        value<uint32_t>(&configured.node.sync_memory_megabytes),
+        "The memory for downloaded blocks awaiting import, above which blocks are spilled to a temporary file, defaults to 1024 (0 disables spilling)."
+    )(
         "node.block_latency_seconds",
         value<uint32_t>(&configured.node.block_latency_seconds),
         "The time to wait for a requested block, defaults to 60."
+    )(
+        "node.block_race_peers",
+        value<uint32_t>(&configured.node.block_race_peers),
+        "The number of announcing peers from which a new block at the chain top is requested, defaults to 1 (racing disabled)."
     )(
         /* Internally this is blockchain, but it is conceptually a node setting. */
         "node.notify_limit_hours",
@@ -558,7 +564,7 @@ options_metadata parser::load_settings() {
     )(
         "node.compact_blocks_high_bandwidth",
         value<bool>(&configured.node.compact_blocks_high_bandwidth),
-        "Compact Blocks High-Bandwidth mode, default to true."
+        "Compact Blocks High-Bandwidth mode for the three peers that first announce new blocks, default to true."
     )(
         "node.ds_proofs",
         value<bool>(&configured.node.ds_proofs_enabled),
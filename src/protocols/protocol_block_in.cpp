@@ -25,6 +25,7 @@
 #endif
 #include <kth/node/define.hpp>
 #include <kth/node/full_node.hpp>
+#include <kth/node/utility/short_id_table.hpp>
 
 namespace kth::node {
 
@@ -93,16 +94,10 @@ void protocol_block_in::start() {
     }
 
     // TODO: move send_compact to a derived class protocol_block_in_70014.
+    // High bandwidth is set once the peer ranks among the first announcers.
     if (compact_from_peer_) {
-        if (chain_.is_stale()) {
-            //force low bandwidth
-            LOG_DEBUG(LOG_NODE, "The chain is stale, send sendcmcpt low bandwidth [", authority(), "]");
-            SEND2((send_compact{false, get_compact_blocks_version()}), handle_send, _1, send_compact::command);
-        } else {
-            LOG_DEBUG(LOG_NODE, "The chain is not stale, send sendcmcpt with configured setting [", authority(), "]");
-            SEND2((send_compact{node_.node_settings().compact_blocks_high_bandwidth, get_compact_blocks_version()}), handle_send, _1, send_compact::command);
-            compact_blocks_high_bandwidth_set_ = node_.node_settings().compact_blocks_high_bandwidth;
-        }
+        LOG_DEBUG(LOG_NODE, "Send sendcmpct low bandwidth [", authority(), "]");
+        SEND2((send_compact{false, get_compact_blocks_version()}), handle_send, _1, send_compact::command);
     }
 
     send_get_blocks(null_hash);
@@ -177,6 +172,10 @@ bool protocol_block_in::handle_receive_headers(code const& ec, headers_const_ptr
         return false;
     }
 
+    if ( ! message->elements().empty()) {
+        announce(message->elements().back().hash());
+    }
+
     // There is no benefit to this use of headers, in fact it is suboptimal.
     // In v3 headers will be used to build block tree before getting blocks.
     auto const response = std::make_shared<get_data>();
@@ -207,6 +206,10 @@ bool protocol_block_in::handle_receive_inventory(code const& ec, inventory_const
         message->reduce(response->inventories(), inventory::type_id::block);
     }
 
+    if ( ! response->inventories().empty()) {
+        announce(response->inventories().back().hash());
+    }
+
     // Remove hashes of blocks that we already have.
     chain_.filter_blocks(response, BIND2(send_get_data, _1, response));
     return true;
@@ -225,40 +228,51 @@ void protocol_block_in::send_get_data(code const& ec, get_data_ptr message) {
         return;
     }
 
-    if (message->inventories().empty()) {
+    auto& tracker = node_.tracker();
+    tracker.expire();
+
+    // At the top a new block is raced from the first peers to announce it, the
+    // first copy is organized and the others are captured as duplicates.
+    auto const race = chain_.is_stale() ? size_t(1) :
+        std::max(size_t(node_.node_settings().block_race_peers), size_t(1));
+
+    // A block requested from other peers is not requested again, unless that
+    // request stalls or its channels stop, when this channel falls back to it.
+    auto const requested = [this, &tracker, race](inventory_vector const& inventory) {
+        return ! tracker.request(inventory.hash(), nonce(), BIND1(send_fallback, _1), race);
+    };
+
+    auto& inventories = message->inventories();
+    inventories.erase(std::remove_if(inventories.begin(), inventories.end(), requested), inventories.end());
+
+    if (inventories.empty()) {
         return;
     }
 
-    if (compact_from_peer_) {
-        if (node_.node_settings().compact_blocks_high_bandwidth) {
-            if ( ! compact_blocks_high_bandwidth_set_ && ! chain_.is_stale() ) {
-                LOG_INFO(LOG_NODE, "The chain is not stale, send sendcmcpt with high bandwidth [", authority(), "]");
-                SEND2((send_compact{true, get_compact_blocks_version()}), handle_send, _1, send_compact::command);
-                compact_blocks_high_bandwidth_set_ = true;
-            }
-        }
-    }
+    send_request(message);
+}
 
+void protocol_block_in::send_request(get_data_ptr message) {
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     mutex.lock_upgrade();
-    auto const fresh = backlog_.empty();
+    auto const fresh = in_flight_.empty();
     mutex.unlock_upgrade_and_lock();
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-    // Enqueue the block inventory behind the preceding block inventory.
+    // Blocks may be received in any order, so only the set is retained.
     for (auto const& inventory: message->inventories()){
         if (inventory.type() == inventory::type_id::block) {
-            backlog_.push(inventory.hash());
+            in_flight_.insert(inventory.hash());
         } else if (inventory.type() == inventory::type_id::compact_block) {
-            backlog_.push(inventory.hash());
+            in_flight_.insert(inventory.hash());
         }
     }
 
     mutex.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
-    // There was no backlog so the timer must be started now.
+    // Nothing was in flight so the timer must be started now.
     if (fresh) {
         reset_timer();
     }
@@ -267,6 +281,56 @@ void protocol_block_in::send_get_data(code const& ec, get_data_ptr message) {
     SEND2(*message, handle_send, _1, message->command);
 }
 
+// The tracker passed a block stalled or abandoned by another channel to this
+// one. The full block is requested, as it is no longer expected to be new.
+void protocol_block_in::send_fallback(hash_digest const& hash) {
+    // Pass the block on again, as this channel may already have released.
+    if (stopped()) {
+        node_.tracker().release(nonce());
+        return;
+    }
+
+    LOG_DEBUG(LOG_NODE
+       , "Requesting stalled block [", encode_hash(hash), "] from ["
+       , authority(), "]");
+
+    send_request(std::make_shared<get_data>(hash_list{ hash }, inventory::type_id::block));
+}
+
+// Announcement ranking.
+//-----------------------------------------------------------------------------
+
+// The last hash of an announcement is the peer's top. Announcements are only
+// ranked at the top, where they are of new blocks.
+void protocol_block_in::announce(hash_digest const& hash) {
+    if ( ! chain_.is_stale()) {
+        node_.announcers().announce(hash, nonce());
+    }
+
+    set_high_bandwidth();
+}
+
+// Only the peers that first announce new blocks push compact blocks unasked,
+// and the set rotates as the ranking changes.
+void protocol_block_in::set_high_bandwidth() {
+    if ( ! compact_from_peer_ || ! node_.node_settings().compact_blocks_high_bandwidth) {
+        return;
+    }
+
+    auto const high = ! chain_.is_stale() && node_.announcers().is_top(nonce());
+
+    // Only the handler that changes the mode sends it.
+    if (compact_blocks_high_bandwidth_set_.exchange(high) == high) {
+        return;
+    }
+
+    LOG_DEBUG(LOG_NODE
+       , "Send sendcmpct ", (high ? "high" : "low"), " bandwidth ["
+       , authority(), "]");
+
+    SEND2((send_compact{high, get_compact_blocks_version()}), handle_send, _1, send_compact::command);
+}
+
 // Receive not_found sequence.
 //-----------------------------------------------------------------------------
 
@@ -307,50 +371,86 @@ bool protocol_block_in::handle_receive_not_found(code const& ec, not_found_const
 //-----------------------------------------------------------------------------
 
 void protocol_block_in::organize_block(block_const_ptr message) {
+    node_.tracker().complete(message->hash());
     message->validation.originator = nonce();
     chain_.organize(message, BIND2(handle_store_block, _1, message));
 }
 
+// Organize the blocks that were held for the parent, once it is stored.
+void protocol_block_in::organize_held(hash_digest const& parent) {
+    std::vector<block_const_ptr> children;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex.lock();
+
+    pending_.erase(parent);
+    auto const range = held_.equal_range(parent);
+
+    for (auto it = range.first; it != range.second; ++it) {
+        children.push_back(it->second);
+    }
+
+    held_.erase(range.first, range.second);
+
+    mutex.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (auto const& child: children) {
+        organize_block(child);
+    }
+}
+
 bool protocol_block_in::handle_receive_block(code const& ec, block_const_ptr message) {
     if (stopped(ec)) {
         return false;
     }
 
+    auto const hash = message->hash();
+    auto const& parent = message->header().previous_block_hash();
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     mutex.lock();
 
-    auto matched = ! backlog_.empty() && backlog_.front() == message->hash();
+    auto const matched = in_flight_.erase(hash) != 0;
+
+    // A block with a parent not yet stored from this peer is held, so that
+    // blocks are organized in dependency order regardless of arrival order.
+    auto const held = matched &&
+        (in_flight_.count(parent) != 0 || pending_.count(parent) != 0);
 
     if (matched) {
-        backlog_.pop();
+        pending_.insert(hash);
+
+        if (held) {
+            held_.emplace(parent, message);
+        }
     }
 
-    // Empty after pop means we need to make a new request.
-    auto const cleared = backlog_.empty();
+    // Empty after erase means we need to make a new request.
+    auto const cleared = in_flight_.empty();
 
     mutex.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
-    // If a peer sends a block unannounced we drop the peer - always. However
-    // it is common for block announcements to cause block requests to be sent
-    // out of backlog order due to interleaving of threads. This results in
-    // channel drops during initial block download but not after sync. The
-    // resolution to this issue is use of headers-first sync, but short of that
-    // the current implementation performs well and drops peers no more
-    // frequently than block announcements occur during initial block download,
-    // and not typically after it is complete.
+    // If a peer sends a block unannounced we drop the peer - always. Blocks
+    // requested in one or more get_data messages are accepted in any order.
     if ( ! matched) {
         LOG_DEBUG(LOG_NODE
-           , "Block [", encode_hash(message->hash())
-           , "] unexpected or out of order from [", authority(), "]");
+           , "Block [", encode_hash(hash)
+           , "] unexpected from [", authority(), "]");
         stop(error::channel_stopped);
         return false;
     }
 
-    // message->validation.originator = nonce();
-    // chain_.organize(message, BIND2(handle_store_block, _1, message));
-    organize_block(message);
+    if (held) {
+        LOG_DEBUG(LOG_NODE
+           , "Holding block [", encode_hash(hash), "] for parent ["
+           , encode_hash(parent), "] from [", authority(), "]");
+    } else {
+        organize_block(message);
+    }
 
     // Sending a new request will reset the timer upon inventory->get_data, but
     // we need to time out the lack of response to those requests when stale.
@@ -369,8 +469,15 @@ bool protocol_block_in::handle_receive_block_transactions(code const& ec, block_
         return false;
     }
 
-    auto it = compact_blocks_map_.find(message->block_hash());
-    if (it == compact_blocks_map_.end()) {
+    // The pending block is moved out of the map, as it is completed or dropped.
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    compact_blocks_mutex_.lock();
+    auto pending = compact_blocks_map_.extract(message->block_hash());
+    compact_blocks_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (pending.empty()) {
         LOG_DEBUG(LOG_NODE
            , "Compact Block [", encode_hash(message->block_hash())
            , "] The blocktxn received doesn't match with any temporal compact block [", authority(), "]");
@@ -378,12 +485,10 @@ bool protocol_block_in::handle_receive_block_transactions(code const& ec, block_
         return false;
     }
 
-    auto temp_compact_block_ = it->second;
-
     auto const& vtx_missing = message->transactions();
 
-    auto& txn_available = temp_compact_block_.transactions;
-    auto const& header_temp = temp_compact_block_.header;
+    auto& txn_available = pending.mapped().transactions;
+    auto& header_temp = pending.mapped().header;
 
     size_t tx_missing_offset = 0;
 
@@ -394,12 +499,11 @@ bool protocol_block_in::handle_receive_block_transactions(code const& ec, block_
                    , "Compact Block [", encode_hash(message->block_hash())
                    , "] The offset ", tx_missing_offset, " is invalid [", authority(), "]");
                 stop(error::channel_stopped);
-
-                //TODO(Mario) verify if necesary mutual exclusion
-                compact_blocks_map_.erase(it);
                 return false;
             }
-            txn_available[i] = std::move(vtx_missing[tx_missing_offset]);
+
+            // The message is shared, so missing transactions are copied.
+            txn_available[i] = vtx_missing[tx_missing_offset];
             ++tx_missing_offset;
         }
     }
@@ -409,17 +513,11 @@ bool protocol_block_in::handle_receive_block_transactions(code const& ec, block_
            , "Compact Block [", encode_hash(message->block_hash())
            , "] The offset ", tx_missing_offset, " is invalid [", authority(), "]");
         stop(error::channel_stopped);
-
-        //TODO(Mario): verify if necesary mutual exclusion
-        compact_blocks_map_.erase(it);
         return false;
     }
 
     auto const tempblock = std::make_shared<domain::message::block>(std::move(header_temp), std::move(txn_available));
     organize_block(tempblock);
-    //TODO(Mario) verify if necesary mutual exclusion
-    compact_blocks_map_.erase(it);
-
     return true;
 }
 
@@ -467,8 +565,17 @@ bool protocol_block_in::handle_receive_compact_block(code const& ec, compact_blo
         return false;
     }
 
+    announce(header_temp.hash());
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    compact_blocks_mutex_.lock_shared();
+    auto const parked = compact_blocks_map_.count(header_temp.hash()) > 0;
+    compact_blocks_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
     //if the compact block exists in the map, is already in process
-    if (compact_blocks_map_.count(header_temp.hash()) > 0) {
+    if (parked) {
         return true;
     }
 
@@ -497,6 +604,8 @@ bool protocol_block_in::handle_receive_compact_block(code const& ec, compact_blo
     auto const& prefiled_txs = message->transactions();
     auto const& short_ids = message->short_ids();
 
+    // The mempool fill assigns transactions by position, copying them, so
+    // every position is constructed here and left invalid until filled.
     std::vector<domain::chain::transaction> txs_available(short_ids.size() + prefiled_txs.size());
     int32_t lastprefilledindex = -1;
 
@@ -590,6 +699,26 @@ bool protocol_block_in::handle_receive_compact_block(code const& ec, compact_blo
     size_t mempool_count = 0;
     chain_.fill_tx_list_from_mempool(*message, mempool_count, txs_available, shorttxids);
 
+    // Transactions seen but not pooled fill those missing from the mempool.
+    // The short id table is built only for this lookup, and if it cannot
+    // place every id the ring is skipped, as the block may still be completed.
+    if (mempool_count < short_ids.size()) {
+        short_id_table table(shorttxids.size());
+        auto placed = true;
+
+        for (auto const& entry: shorttxids) {
+            if ( ! table.insert(entry.first, entry.second)) {
+                placed = false;
+                break;
+            }
+        }
+
+        if (placed) {
+            auto const key = short_id_table::make_key(header_temp, nonce);
+            node_.extra_transactions().fill(key, table, txs_available);
+        }
+    }
+
     std::vector<uint64_t> txs;
     size_t prev_idx = 0;
 
@@ -607,8 +736,16 @@ bool protocol_block_in::handle_receive_compact_block(code const& ec, compact_blo
         organize_block(tempblock);
         return true;
     } else {
-        compact_blocks_map_.emplace(header_temp.hash(), temp_compact_block{std::move(header_temp), std::move(txs_available)});
-        auto req_tx = get_block_transactions(header_temp.hash(),txs);
+        auto const hash = header_temp.hash();
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        compact_blocks_mutex_.lock();
+        compact_blocks_map_.emplace(hash, temp_compact_block{header_temp, std::move(txs_available)});
+        compact_blocks_mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        auto req_tx = get_block_transactions(hash, txs);
         SEND2(req_tx, handle_send, _1, get_block_transactions::command);
         return true;
     }
@@ -621,7 +758,12 @@ void protocol_block_in::send_get_data_compact_block(code const& ec, hash_digest
     get_data_ptr request;
     request = std::make_shared<get_data>(hashes, inventory::type_id::block);
 
-    send_get_data(ec,request);
+    // The block is tracked for this channel by its compact block request.
+    if (stopped(ec)) {
+        return;
+    }
+
+    send_request(request);
 }
 
 // The block has been saved to the block chain (or not).
@@ -634,6 +776,9 @@ void protocol_block_in::handle_store_block(code const& ec, block_const_ptr messa
 
     auto const hash = message->header().hash();
 
+    // Children are organized after the parent whether or not it was accepted.
+    organize_held(hash);
+
     // Ask the peer for blocks from the chain top up to this orphan.
     if (ec == error::orphan_block) {
         send_get_blocks(hash);
@@ -703,15 +848,18 @@ void protocol_block_in::handle_timeout(code const& ec) {
         return;
     }
 
+    // Stalled requests of other channels may pass to this one.
+    node_.tracker().expire();
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     mutex.lock_shared();
-    auto const backlog_empty = backlog_.empty();
+    auto const in_flight_empty = in_flight_.empty();
     mutex.unlock_shared();
     ///////////////////////////////////////////////////////////////////////////
 
     // Can only end up here if time was not extended.
-    if ( ! backlog_empty) {
+    if ( ! in_flight_empty) {
         LOG_DEBUG(LOG_NODE
            , "Peer [", authority()
            , "] exceeded configured block latency.");
@@ -735,6 +883,10 @@ void protocol_block_in::handle_timeout(code const& ec) {
 }
 
 void protocol_block_in::handle_stop(code const&) {
+    // Blocks requested by this channel and not received pass to other peers.
+    node_.tracker().release(nonce());
+    node_.announcers().remove(nonce());
+
     LOG_DEBUG(LOG_NETWORK, "Stopped block_in protocol for [", authority(), "].");
 }
 
@@ -94,12 +94,6 @@ bool protocol_block_sync::handle_receive_block(code const& ec, block_const_ptr m
     reservation_->import(message);
 #endif
 
-    if (reservation_->toggle_partitioned()) {
-        LOG_DEBUG(LOG_NODE, "Restarting partitioned slot (", reservation_->slot(), ").");
-        complete(error::channel_stopped);
-        return false;
-    }
-
     // Request more blocks if our reservation has been expanded.
     send_get_blocks(complete, false);
     return true;
@@ -119,6 +113,10 @@ void protocol_block_sync::handle_event(code const& ec, event_handler complete) {
         return;
     }
 
+    // A reservation emptied by the cancellation of duplicated requests is
+    // not populated by an import, so populate it here.
+    reservation_->populate();
+
     // This results from other channels taking this channel's hashes in
     // combination with this channel's peer not responding to the last request.
     // Causing a successful stop here prevents channel startup just to stop.
@@ -133,6 +131,9 @@ void protocol_block_sync::handle_event(code const& ec, event_handler complete) {
         complete(error::channel_timeout);
         return;
     }
+
+    // Send any request deferred while the import queue was full.
+    send_get_blocks(complete, false);
 }
 
 void protocol_block_sync::blocks_complete(code const& ec, event_handler handler) {
@@ -51,6 +51,19 @@ void protocol_header_sync::start(event_handler handler) {
 
     SUBSCRIBE3(headers, handle_receive_headers, _1, _2, complete);
 
+    // A tail list is filled up to the top advertised by its current peer.
+    if (headers_->tail()) {
+        headers_->set_target(peer_version()->start_height());
+
+        if (headers_->complete()) {
+            LOG_DEBUG(LOG_NODE
+               , "No headers above [", headers_->previous_height()
+               , "] from [", authority(), "]");
+            complete(error::success);
+            return;
+        }
+    }
+
     // This is the end of the start sequence.
     send_get_headers(complete);
 }
@@ -97,8 +110,15 @@ bool protocol_header_sync::handle_receive_headers(code const& ec, headers_const_
         return false;
     }
 
-    // If we received fewer than 2000 the peer is exhausted, try another.
+    // If we received fewer than 2000 the peer is exhausted.
     if (message->elements().size() < max_get_headers) {
+        // The tail has reached the peer's top, which may have moved back.
+        if (headers_->tail()) {
+            complete(error::success);
+            return false;
+        }
+
+        // Try another.
         complete(error::operation_failed);
         return false;
     }
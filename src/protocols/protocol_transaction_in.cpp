@@ -36,6 +36,7 @@ uint64_t to_relay_fee(float minimum_byte_fee) {
 
 protocol_transaction_in::protocol_transaction_in(full_node& node, channel::ptr channel, safe_chain& chain)
     : protocol_events(node, channel, NAME)
+    , node_(node)
     , chain_(chain)
 
     // TODO: move fee_filter to a derived class protocol_transaction_in_70013.
@@ -185,6 +186,12 @@ void protocol_transaction_in::handle_store_transaction(code const& ec, transacti
     // TODO: differentiate failure conditions and send reject as applicable.
 
     if (ec) {
+        // A transaction not pooled may yet be mined, so it is kept for the
+        // reconstruction of compact blocks.
+        if (ec != error::duplicate_transaction) {
+            node_.extra_transactions().store(message);
+        }
+
         // This should not happen with a single peer since we filter inventory.
         // However it will happen when a block or another peer's tx intervenes.
         LOG_DEBUG(LOG_NODE
@@ -17,6 +17,7 @@
 #include <kth/node/settings.hpp>
 #include <kth/node/utility/check_list.hpp>
 #include <kth/node/utility/reservation.hpp>
+#include <kth/node/utility/sync_state.hpp>
 
 namespace kth::node {
 
@@ -32,10 +33,11 @@ using namespace std::placeholders;
 // The interval in which all-channel block download performance is tested.
 static const asio::seconds regulator_interval(5);
 
-session_block_sync::session_block_sync(full_node& network, check_list& hashes, fast_chain& chain, settings const& settings)
+session_block_sync::session_block_sync(full_node& network, check_list& hashes, sync_state& state, block_chain& chain, settings const& settings)
     : session<kth::network::session_outbound>(network, false)
     , chain_(chain)
-    , reservations_(hashes, chain, settings)
+    , reservations_(hashes, state, chain, settings)
+    , state_(state)
     , CONSTRUCT_TRACK(session_block_sync)
 {}
 
@@ -60,7 +62,9 @@ void session_block_sync::handle_started(code const& ec, result_handler handler)
     // Copy the reservations table.
     auto const table = reservations_.table();
 
+    // Nothing remains to be imported, so the persisted headers are stale.
     if (table.empty()) {
+        state_.remove();
         handler(error::success);
         return;
     }
@@ -71,14 +75,16 @@ void session_block_sync::handle_started(code const& ec, result_handler handler)
         return;
     }
 
-    auto const complete = synchronize<result_handler>(BIND2(handle_complete, _1, handler), table.size(), NAME);
+    // Slots are added and retired by the regulator until all are complete.
+    slots_.store(table.size());
+    complete_ = BIND2(handle_slot_complete, _1, handler);
 
     // This is the end of the start sequence.
     for (auto const row : table) {
-        new_connection(row, complete);
+        new_connection(row, complete_);
     }
 
-    ////reset_timer();
+    reset_timer();
 }
 
 // Block sync sequence.
@@ -159,7 +165,6 @@ void session_block_sync::handle_channel_complete(code const& ec, reservation::pt
         return;
     }
 
-    timer_->stop();
     reservations_.remove(row);
 
     LOG_DEBUG(LOG_NODE, "Completed block slot (", row->slot(), ")");
@@ -174,7 +179,29 @@ void session_block_sync::handle_channel_stop(code const& ec, reservation::ptr ro
        , ec.message());
 }
 
+void session_block_sync::handle_slot_complete(code const& ec, result_handler handler) {
+    // The last slot to complete completes the sync.
+    if (--slots_ == 0) {
+        handle_complete(ec, handler);
+    }
+}
+
+// Count an added slot, false if the sync has already completed.
+bool session_block_sync::add_slot() {
+    auto slots = slots_.load();
+
+    while (slots != 0) {
+        if (slots_.compare_exchange_weak(slots, slots + 1)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void session_block_sync::handle_complete(code const& ec, result_handler handler) {
+    timer_->stop();
+
     // Always stop but give sync priority over stop for reporting.
     auto const stop = reservations_.stop();
 
@@ -185,11 +212,14 @@ void session_block_sync::handle_complete(code const& ec, result_handler handler)
     }
 
     if ( ! stop) {
-        LOG_DEBUG(LOG_NODE, "Failed to reset write lock: ", ec.message());
+        LOG_DEBUG(LOG_NODE, "Failed to import all blocks.");
         handler(error::operation_failed);
         return;
     }
 
+    // The persisted headers are no longer required to resume.
+    state_.remove();
+
     LOG_DEBUG(LOG_NODE, "Completed block sync.");
     handler(ec);
 }
@@ -207,21 +237,23 @@ void session_block_sync::reset_timer() {
 }
 
 void session_block_sync::handle_timer(code const& ec) {
-    if (stopped()) {
+    // The timer is stopped on completion, after which no slot is added.
+    if (stopped() || slots_.load() == 0) {
         return;
     }
 
     LOG_DEBUG(LOG_NODE, "Fired session_block_sync timer: ", ec.message());
 
-    ////// TODO: If (total database time as a fn of total time) add a channel.
-    ////// TODO: push into reservations_ implementation.
-    ////// TODO: add a boolean increment method to the synchronizer and pass here.
-    ////size_t const id = reservations_.table().size();
-    ////auto const row = std::make_shared<reservation>(reservations_, id);
-    ////const synchronizer<result_handler> handler({}, 0, "name", true);
-    ////if (add) new_connection(row, handler);
-    ////// TODO: drop the slowest channel
-    //////If (drop) reservations_.prune();
+    // Add a slot while doing so increases aggregate throughput.
+    if (reservations_.regulate() && add_slot()) {
+        auto const row = reservations_.add();
+
+        if (row) {
+            new_connection(row, complete_);
+        } else {
+            complete_(error::success);
+        }
+    }
 
     reset_timer();
 }
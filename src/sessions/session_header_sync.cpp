@@ -39,12 +39,16 @@ static constexpr float back_off_factor = 0.75f;
 static constexpr uint32_t headers_per_second = 10000;
 
 // Sort is required here but not in configuration settings.
-session_header_sync::session_header_sync(full_node& network, check_list& hashes, fast_chain& blockchain, infrastructure::config::checkpoint::list const& checkpoints)
+session_header_sync::session_header_sync(full_node& network, check_list& hashes, sync_state& state, fast_chain& blockchain, infrastructure::config::checkpoint::list const& checkpoints, settings const& settings)
     : session<kth::network::session_outbound>(network, false)
     , hashes_(hashes)
     , minimum_rate_(headers_per_second)
     , chain_(blockchain)
     , checkpoints_(infrastructure::config::checkpoint::sort(checkpoints))
+    , slots_(std::max(settings.sync_peers, 1u))
+    , state_(state)
+    , next_slot_(0)
+    , persisted_(false)
     , CONSTRUCT_TRACK(session_header_sync)
 {
     static_assert(back_off_factor < 1.0, "invalid back-off factor");
@@ -63,9 +67,6 @@ void session_header_sync::handle_started(code const& ec, result_handler handler)
         return;
     }
 
-    // TODO: expose header count and emit here.
-    LOG_INFO(LOG_NODE, "Getting headers.");
-
     if ( ! initialize()) {
         handler(error::operation_failed);
         return;
@@ -153,34 +154,23 @@ void session_header_sync::attach_protocols(channel::ptr channel, header_list::pt
     }
 
     attach<protocol_address_31402>(channel)->start();
-    attach<protocol_header_sync>(channel, row, minimum_rate_)->start(BIND3(handle_complete, _1, row, handler));
+    attach<protocol_header_sync>(channel, row, minimum_rate_.load())->start(BIND3(handle_complete, _1, row, handler));
 }
 
 void session_header_sync::handle_complete(code const& ec, header_list::ptr row, result_handler handler) {
     if (ec) {
         // Reduce the rate minimum so that we don't get hung up.
-        minimum_rate_ = static_cast<uint32_t>(minimum_rate_ * back_off_factor);
+        minimum_rate_.store(static_cast<uint32_t>(minimum_rate_ * back_off_factor));
 
         // There is no failure scenario, we ignore the result code here.
         new_connection(row, handler);
         return;
     }
 
-    //*************************************************************************
-    // TODO: as each header sink slot completes store headers to database and
-    // assign its checkpoints to hashes_, terminating the slot.
-    //*************************************************************************
-
-    auto height = row->first_height();
-    auto const& headers = row->headers();
-
-    // Store the hash if there is a gap reservation.
-    for (auto const& header: headers) {
-        hashes_.enqueue(header.hash(), height++);
-    }
-
     LOG_DEBUG(LOG_NODE, "Completed header slot (", row->slot(), ")");
 
+    enqueue(row);
+
     // This is the end of the header sync sequence.
     handler(error::success);
 }
@@ -199,14 +189,206 @@ bool session_header_sync::initialize() {
         LOG_ERROR(LOG_NODE, "Block hash list must not be initialized.");
         return false;
     }
-    //*************************************************************************
-    // TODO: get top and pair up checkpoints into slots.
-    auto const& front = checkpoints_.front();
-    auto const& back = checkpoints_.back();
-    headers_.push_back(std::make_shared<header_list>(0, front, back));
-    //*************************************************************************
+
+    size_t top_height;
+    hash_digest top_hash;
+
+    if ( ! chain_.get_last_height(top_height) ||
+         ! chain_.get_block_hash(top_hash, top_height)) {
+        LOG_ERROR(LOG_NODE, "The blockchain is corrupt.");
+        return false;
+    }
+
+    // The top block is the start of the list, it links the first header.
+    infrastructure::config::checkpoint start{ top_hash, top_height };
+
+    // Headers persisted by an interrupted sync move the start above them.
+    auto const resumed = resume(start);
+
+    // Checkpointed slots are only partitioned below the last checkpoint.
+    auto const checkpointed = ! checkpoints_.empty() &&
+        checkpoints_.back().height() > start.height();
+
+    if (checkpointed) {
+        auto const& stop = checkpoints_.back();
+        partition(start);
+
+        // The file is only created when there are headers to persist.
+        if ( ! resumed && ! state_.create(start.height() + 1)) {
+            LOG_WARNING(LOG_NODE, "Failure creating the sync state file.");
+        }
+
+        // Reserve a hash slot for each height to be populated by header sync.
+        hashes_.reserve(start.height() + 1, stop.height());
+
+        LOG_INFO(LOG_NODE
+           , "Getting headers from [", start.height(), "] to checkpoint ["
+           , stop.height(), "] in (", headers_.size(), ") slots.");
+    } else if ( ! resumed) {
+        // A state file with nothing left to resume is stale.
+        state_.remove();
+    }
+
+    persisted_ = checkpointed || resumed;
+
+    // The tail continues from the last checkpoint (or start) to the peer's
+    // top. Its heights are reserved once it completes, as its size is not
+    // known, and its blocks are fully validated on import.
+    auto const& tail_start = checkpointed ? checkpoints_.back() : start;
+    headers_.push_back(std::make_shared<header_list>(headers_.size(), tail_start));
+    completed_.assign(headers_.size(), false);
+
+    LOG_INFO(LOG_NODE
+       , "Getting headers above [", tail_start.height(), "] in tail slot ("
+       , headers_.back()->slot(), ").");
 
     return true;
 }
 
-} // namespace kth::node
\ No newline at end of file
+// The persisted headers are used only if they link the top block, so that
+// they describe the chain being extended. Their hashes above the top block
+// are queued as if obtained by header sync, and the start is moved above.
+bool session_header_sync::resume(infrastructure::config::checkpoint& start) {
+    size_t first;
+    domain::chain::header::list headers;
+
+    if ( ! state_.open(first, headers)) {
+        return false;
+    }
+
+    // All blocks below the persisted import height are stored, and it may
+    // lag the store, so the top is the highest height above it with no gap
+    // below. Blocks are imported in order, so this is normally the last.
+    hash_digest top_hash;
+    auto top = state_.import_height();
+
+    while (top <= start.height() && chain_.get_block_hash(top_hash, top)) {
+        ++top;
+    }
+
+    if (top == 0 || ! chain_.get_block_hash(top_hash, --top)) {
+        return false;
+    }
+
+    if (top != start.height()) {
+        LOG_WARNING(LOG_NODE
+           , "Resuming from [", top, "] below the top block [", start.height()
+           , "], as there is a gap above it.");
+    }
+
+    // Nothing remains if the top block is at or above the last header.
+    if (top + 1 < first || top + 1 >= first + headers.size()) {
+        return false;
+    }
+
+    auto const anchor = top + 1 == first ?
+        headers.front().previous_block_hash() : headers[top - first].hash();
+
+    if (anchor != top_hash) {
+        LOG_INFO(LOG_NODE, "Discarding sync state not linked to the top block.");
+        return false;
+    }
+
+    hash_list hashes;
+    hashes.reserve(first + headers.size() - top - 1);
+
+    for (auto it = headers.begin() + (top + 1 - first); it != headers.end(); ++it) {
+        hashes.push_back(it->hash());
+    }
+
+    auto const last = top + hashes.size();
+    hashes_.reserve(top + 1, last);
+    hashes_.enqueue(hashes, top + 1);
+
+    start = { hashes.back(), last };
+
+    LOG_INFO(LOG_NODE
+       , "Resumed (", hashes.size(), ") headers from [", top + 1, "] to ["
+       , last, "].");
+
+    return true;
+}
+
+// Split the checkpoints above start into up to slots_ ranges of similar
+// height. Each range starts and stops on a checkpoint so that every slot is
+// anchored and verified independently of the others.
+void session_header_sync::partition(infrastructure::config::checkpoint const& start) {
+    auto const above = [](size_t height, infrastructure::config::checkpoint const& check) {
+        return height < check.height();
+    };
+
+    auto const first = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), start.height(), above);
+    auto const boundaries = static_cast<size_t>(std::distance(first, checkpoints_.end()));
+    auto const slots = std::min(slots_, boundaries);
+    auto const span = checkpoints_.back().height() - start.height();
+    auto const* previous = &start;
+
+    for (auto it = first; it != checkpoints_.end(); ++it) {
+        auto const slot = headers_.size();
+        auto const last = std::next(it) == checkpoints_.end();
+
+        // The slot target height, the last slot always closes the range.
+        auto const target = start.height() + (span * (slot + 1)) / slots;
+
+        if (last || it->height() >= target) {
+            headers_.push_back(std::make_shared<header_list>(slot, *previous, *it));
+            previous = &(*it);
+        }
+    }
+}
+
+// Slots complete in any order but hashes are enqueued in height order, so a
+// completed slot waits for all of its predecessors to complete.
+void session_header_sync::enqueue(header_list::ptr row) {
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    completed_[row->slot()] = true;
+
+    for (; next_slot_ < headers_.size() && completed_[next_slot_]; ++next_slot_) {
+        auto const& slot = headers_[next_slot_];
+        auto const height = slot->first_height();
+
+        if (slot->tail()) {
+            if (slot->headers().empty()) {
+                LOG_DEBUG(LOG_NODE, "No headers above [", height - 1, "].");
+                continue;
+            }
+
+            // The tail extends the reservation of the checkpointed slots.
+            hashes_.reserve(height, slot->previous_height());
+
+            // The file is only created when there are headers to persist.
+            if ( ! persisted_) {
+                persisted_ = state_.create(height);
+
+                if ( ! persisted_) {
+                    LOG_WARNING(LOG_NODE, "Failure creating the sync state file.");
+                }
+            }
+        }
+
+        hash_list hashes;
+        hashes.reserve(slot->headers().size());
+
+        for (auto const& header: slot->headers()) {
+            hashes.push_back(header.hash());
+        }
+
+        // Store the hashes if there is a gap reservation.
+        hashes_.enqueue(hashes, height);
+
+        // Persist the headers so that a restart resumes above them.
+        if ( ! state_.append(slot->headers(), height)) {
+            LOG_DEBUG(LOG_NODE, "Header slot (", slot->slot(), ") not persisted.");
+        }
+
+        LOG_DEBUG(LOG_NODE
+           , "Enqueued header slot (", slot->slot(), ") through ["
+           , slot->previous_height(), "].");
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace kth::node
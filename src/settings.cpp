@@ -13,7 +13,9 @@ using namespace kth::asio;
 settings::settings()
     : sync_peers(0)
     , sync_timeout_seconds(5)
+    , sync_memory_megabytes(1024)
     , block_latency_seconds(60)
+    , block_race_peers(1)
     , refresh_transactions(true)
     , compact_blocks_high_bandwidth(true)
     , ds_proofs_enabled(false)
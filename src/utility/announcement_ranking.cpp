@@ -0,0 +1,88 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/announcement_ranking.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace kth::node {
+
+announcement_ranking::announcement_ranking(size_t top, size_t window)
+    : top_(top)
+    , window_(window)
+{}
+
+void announcement_ranking::announce(hash_digest const& hash, uint64_t channel) {
+    auto const same = [&hash](announcement const& item) {
+        return item.first == hash;
+    };
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (window_ == 0 || std::any_of(firsts_.begin(), firsts_.end(), same)) {
+        return;
+    }
+
+    firsts_.emplace_back(hash, channel);
+
+    if (firsts_.size() > window_) {
+        firsts_.pop_front();
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool announcement_ranking::is_top(uint64_t channel) const {
+    // Credits and the position of the latest credit, by channel.
+    std::unordered_map<uint64_t, std::pair<size_t, size_t>> credits;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(mutex_);
+
+        for (size_t position = 0; position < firsts_.size(); ++position) {
+            auto& credit = credits[firsts_[position].second];
+            ++credit.first;
+            credit.second = position;
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    auto const it = credits.find(channel);
+
+    if (it == credits.end()) {
+        return false;
+    }
+
+    // The channel is in the top if fewer than top channels rank above it.
+    auto const& own = it->second;
+    size_t above = 0;
+
+    for (auto const& item: credits) {
+        if (item.second > own) {
+            ++above;
+        }
+    }
+
+    return above < top_;
+}
+
+void announcement_ranking::remove(uint64_t channel) {
+    auto const same = [channel](announcement const& item) {
+        return item.second == channel;
+    };
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    firsts_.erase(std::remove_if(firsts_.begin(), firsts_.end(), same), firsts_.end());
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace kth::node
@@ -0,0 +1,83 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/block_sizes.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace kth::node {
+
+block_sizes::block_sizes(uint64_t default_size)
+    : default_size_(std::max(default_size, uint64_t{ 1 }))
+    , latest_bucket_(0)
+    , latest_(default_size_)
+{}
+
+void block_sizes::record(size_t height, uint64_t size) {
+    auto const index = height / interval;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (index >= buckets_.size()) {
+        buckets_.resize(index + 1, { 0, 0 });
+    }
+
+    auto& entry = buckets_[index];
+    entry.bytes += size;
+    ++entry.count;
+
+    if (index >= latest_bucket_) {
+        latest_bucket_ = index;
+        latest_ = std::max(entry.bytes / entry.count, uint64_t{ 1 });
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+uint64_t block_sizes::estimate(size_t height) const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return get_estimate(height);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_sizes::count(size_t first, uint64_t bytes, size_t maximum) const {
+    size_t result = 0;
+    uint64_t total = 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    for (; result < maximum; ++result) {
+        total += get_estimate(first + result);
+
+        if (total > bytes) {
+            break;
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    return std::min(std::max(result, size_t{ 1 }), maximum);
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+uint64_t block_sizes::get_estimate(size_t height) const {
+    auto const index = height / interval;
+
+    if (index < buckets_.size() && buckets_[index].count != 0) {
+        auto const& entry = buckets_[index];
+        return std::max(entry.bytes / entry.count, uint64_t{ 1 });
+    }
+
+    return latest_;
+}
+
+} // namespace kth::node
@@ -0,0 +1,170 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/block_tracker.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace kth::node {
+
+block_tracker::block_tracker(clock::duration timeout)
+    : timeout_(timeout)
+{}
+
+size_t block_tracker::size() const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return entries_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool block_tracker::request(hash_digest const& hash, uint64_t channel, handler fallback, size_t race) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    auto const time = now();
+    auto const it = entries_.find(hash);
+
+    if (it == entries_.end()) {
+        entries_.emplace(hash, entry{ { channel }, time, {} });
+        return true;
+    }
+
+    auto& value = it->second;
+    auto& channels = value.channels;
+
+    if (std::find(channels.begin(), channels.end(), channel) != channels.end()) {
+        return false;
+    }
+
+    auto const same = [channel](waiter const& item) {
+        return item.first == channel;
+    };
+
+    auto& waiting = value.waiting;
+    auto const found = std::find_if(waiting.begin(), waiting.end(), same);
+
+    auto const stalled = time - value.requested >= timeout_;
+
+    // The announcing channel joins a race, or renews a stalled request.
+    if (stalled || channels.size() < race) {
+        if (found != waiting.end()) {
+            waiting.erase(found);
+        }
+
+        channels.push_back(channel);
+
+        if (stalled) {
+            value.requested = time;
+        }
+
+        return true;
+    }
+
+    if (found == waiting.end()) {
+        waiting.emplace_back(channel, std::move(fallback));
+    }
+
+    return false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_tracker::complete(hash_digest const& hash) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    entries_.erase(hash);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_tracker::release(uint64_t channel) {
+    fallbacks reassigned;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+        auto const time = now();
+
+        auto const same = [channel](waiter const& item) {
+            return item.first == channel;
+        };
+
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            auto& value = it->second;
+            auto& waiting = value.waiting;
+            auto& channels = value.channels;
+            waiting.erase(std::remove_if(waiting.begin(), waiting.end(), same), waiting.end());
+            channels.erase(std::remove(channels.begin(), channels.end(), channel), channels.end());
+
+            if (channels.empty() && ! reassign(it->first, value, time, reassigned)) {
+                it = entries_.erase(it);
+                continue;
+            }
+
+            ++it;
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    invoke(reassigned);
+}
+
+void block_tracker::expire() {
+    fallbacks reassigned;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+        auto const time = now();
+
+        // A stalled request without a waiting channel remains with its channels.
+        for (auto& item: entries_) {
+            if (time - item.second.requested >= timeout_) {
+                reassign(item.first, item.second, time, reassigned);
+            }
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    invoke(reassigned);
+}
+
+// protected
+//-----------------------------------------------------------------------------
+
+block_tracker::clock::time_point block_tracker::now() const {
+    return clock::now();
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+bool block_tracker::reassign(hash_digest const& hash, entry& value, clock::time_point time, fallbacks& out) {
+    if (value.waiting.empty()) {
+        return false;
+    }
+
+    auto next = std::move(value.waiting.front());
+    value.waiting.erase(value.waiting.begin());
+    value.channels.push_back(next.first);
+    value.requested = time;
+    out.emplace_back(hash, std::move(next.second));
+    return true;
+}
+
+// Handlers send requests, so they are not invoked under the lock.
+void block_tracker::invoke(fallbacks const& reassigned) {
+    for (auto const& item: reassigned) {
+        item.second(item.first);
+    }
+}
+
+} // namespace kth::node
@@ -4,9 +4,9 @@
 
 #include <kth/node/utility/check_list.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <utility>
-#include <boost/bimap/support/lambda.hpp>
 #include <kth/blockchain.hpp>
 
 namespace kth::node {
@@ -14,53 +14,93 @@ namespace kth::node {
 using namespace kth::database;
 
 bool check_list::empty() const {
-    ///////////////////////////////////////////////////////////////////////////
-    // Critical Section
-    shared_lock lock(mutex_);
-
-    return checks_.empty();
-    ///////////////////////////////////////////////////////////////////////////
+    return size_.load() == 0;
 }
 
 size_t check_list::size() const {
-    ///////////////////////////////////////////////////////////////////////////
+    return size_.load();
+}
+
+size_t check_list::first() const {
     // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
     shared_lock lock(mutex_);
-
-    return checks_.size();
+    return first_;
     ///////////////////////////////////////////////////////////////////////////
 }
 
-void check_list::reserve(const heights& heights) {
+bool check_list::reserve(size_t first, size_t last) {
+    if (last < first) {
+        return true;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     unique_lock lock(mutex_);
 
-    checks_.clear();
+    if (first_ == end_) {
+        // Retain one chunk for reuse, the rest is released.
+        if ( ! chunks_.empty() && ! spare_) {
+            spare_ = std::move(chunks_.front());
+        }
+
+        chunks_.clear();
+        base_ = first - (first % chunk_size);
+        first_ = first;
+        end_ = first;
+    } else if (first != end_) {
+        return false;
+    }
+
+    // This addition is safe.
+    auto const end = last + 1;
 
-    for (auto const height : heights) {
-        auto const it = checks_.insert({ null_hash, height });
+    while (base_ + chunks_.size() * chunk_size < end) {
+        chunks_.push_back(spare_ ? std::move(spare_) : std::make_unique<chunk>());
     }
 
+    // Chunks are reused, so the new range must be cleared.
+    for (auto height = end_; height < end; ++height) {
+        at(height) = null_hash;
+    }
+
+    size_ += end - end_;
+    end_ = end;
+    return true;
     ///////////////////////////////////////////////////////////////////////////
 }
 
-
 void check_list::enqueue(hash_digest&& hash, size_t height) {
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     unique_lock lock(mutex_);
 
-    using namespace boost::bimaps;
-    auto const it = checks_.right.find(height);
-
     // Ignore the entry if it is not reserved.
-    if (it == checks_.right.end()) {
+    if (height < first_ || height >= end_) {
         return;
     }
 
-    KTH_ASSERT(it->second == null_hash);
-    checks_.right.modify_data(it, _data = std::move(hash));
+    auto& entry = at(height);
+    KTH_ASSERT(entry == null_hash);
+    entry = std::move(hash);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void check_list::enqueue(hash_list const& hashes, size_t first_height) {
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    auto height = first_height;
+
+    for (auto const& hash: hashes) {
+        // Ignore the entry if it is not reserved.
+        if (height >= first_ && height < end_) {
+            at(height) = hash;
+        }
+
+        ++height;
+    }
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -70,16 +110,50 @@ bool check_list::dequeue(hash_digest& out_hash, size_t& out_height) {
     unique_lock lock(mutex_);
 
     // Overlocking to reduce code in the dominant path.
-    if (checks_.empty()) {
+    if (first_ == end_) {
         return false;
     }
 
-    auto it = checks_.right.begin();
-    out_height = it->first;
-    out_hash = it->second;
-    checks_.right.erase(it);
+    out_height = first_;
+    out_hash = at(first_++);
+    --size_;
+    trim();
     return true;
     ///////////////////////////////////////////////////////////////////////////
 }
 
+size_t check_list::dequeue_n(checks& out, size_t count) {
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    auto const removed = std::min(count, end_ - first_);
+    out.reserve(out.size() + removed);
+
+    for (size_t index = 0; index < removed; ++index, ++first_) {
+        out.emplace_back(at(first_), first_);
+    }
+
+    size_ -= removed;
+    trim();
+    return removed;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+hash_digest& check_list::at(size_t height) {
+    auto const offset = height - base_;
+    return (*chunks_[offset / chunk_size])[offset % chunk_size];
+}
+
+void check_list::trim() {
+    while (first_ - base_ >= chunk_size) {
+        spare_ = std::move(chunks_.front());
+        chunks_.pop_front();
+        base_ += chunk_size;
+    }
+}
+
 } // namespace kth::node
@@ -0,0 +1,244 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/hash_heights.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace kth::node {
+
+// The minimum index capacity, must be a power of two.
+static constexpr size_t minimum_capacity = 64;
+
+// The number of erased entries tolerated before the array is compacted.
+static constexpr size_t minimum_garbage = 1024;
+
+bool hash_heights::empty() const {
+    return size_ == 0;
+}
+
+size_t hash_heights::size() const {
+    return size_;
+}
+
+size_t hash_heights::requested() const {
+    return requested_;
+}
+
+void hash_heights::reset_requested() {
+    for (auto& item: entries_) {
+        item.requested = false;
+    }
+
+    requested_ = 0;
+}
+
+void hash_heights::clear() {
+    entries_.clear();
+    index_.clear();
+    front_ = 0;
+    size_ = 0;
+    used_ = 0;
+    requested_ = 0;
+}
+
+void hash_heights::insert(hash_digest const& hash, size_t height) {
+    // Entries are usually added by increasing height, requiring no shift.
+    if (entries_.size() == front_ || entries_.back().height < height) {
+        entries_.push_back({ hash, height, false, false });
+        add(entries_.size() - 1);
+        ++size_;
+        return;
+    }
+
+    auto const below = [](size_t value, entry const& item) {
+        return value < item.height;
+    };
+
+    // Positions above the insertion point shift, so the index is rebuilt.
+    auto const begin = entries_.begin() + front_;
+    auto const it = std::upper_bound(begin, entries_.end(), height, below);
+    entries_.insert(it, { hash, height, false, false });
+    ++size_;
+    rebuild(index_.size());
+}
+
+bool hash_heights::find_and_erase(hash_digest const& hash, size_t& out_height) {
+    auto const found = find(hash);
+
+    if (found == index_.size()) {
+        return false;
+    }
+
+    auto& item = entries_[index_[found]];
+    out_height = item.height;
+    item.erased = true;
+    index_[found] = tombstone;
+    --size_;
+
+    if (item.requested) {
+        --requested_;
+    }
+
+    // Blocks arrive mostly in height order, so skip the erased prefix.
+    while (front_ < entries_.size() && entries_[front_].erased) {
+        ++front_;
+    }
+
+    if (size_ == 0) {
+        clear();
+    } else if (entries_.size() - size_ > std::max(size_, minimum_garbage)) {
+        compact();
+    }
+
+    return true;
+}
+
+size_t hash_heights::move_back(hash_heights& out, size_t count) {
+    count = std::min(count, size_);
+    out.clear();
+
+    if (count == 0) {
+        return 0;
+    }
+
+    // Find the start of the range holding the count highest live entries.
+    size_t moved = 0;
+    auto cut = entries_.size();
+
+    while (moved < count) {
+        if ( ! entries_[--cut].erased) {
+            ++moved;
+        }
+    }
+
+    // The range is sorted and above any other entry, so it is moved whole.
+    auto const begin = entries_.begin() + cut;
+    out.entries_.reserve(count);
+
+    for (auto it = begin; it != entries_.end(); ++it) {
+        if ( ! it->erased) {
+            out.entries_.push_back({ it->hash, it->height, false, false });
+            index_[find(it->hash)] = tombstone;
+
+            if (it->requested) {
+                --requested_;
+            }
+        }
+    }
+
+    out.size_ = count;
+    out.rebuild(0);
+
+    entries_.erase(begin, entries_.end());
+    size_ -= count;
+
+    if (size_ == 0) {
+        clear();
+    }
+
+    return count;
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+// Block hashes are uniformly distributed, so any eight bytes are a good key.
+size_t hash_heights::bucket(hash_digest const& hash, size_t capacity) {
+    uint64_t key;
+    std::memcpy(&key, hash.data(), sizeof(key));
+    return static_cast<size_t>(key) & (capacity - 1);
+}
+
+size_t hash_heights::find(hash_digest const& hash) const {
+    auto const capacity = index_.size();
+
+    if (capacity == 0) {
+        return capacity;
+    }
+
+    auto position = bucket(hash, capacity);
+
+    for (size_t probe = 0; probe < capacity; ++probe) {
+        auto const value = index_[position];
+
+        if (value == empty_slot) {
+            break;
+        }
+
+        if (value != tombstone && entries_[value].hash == hash) {
+            return position;
+        }
+
+        position = (position + 1) & (capacity - 1);
+    }
+
+    return capacity;
+}
+
+void hash_heights::add(size_t position) {
+    // Keep the load (including tombstones) at or below one half.
+    if ((used_ + 1) * 2 > index_.size()) {
+        rebuild(index_.size() * 2);
+        return;
+    }
+
+    auto const capacity = index_.size();
+    auto slot = bucket(entries_[position].hash, capacity);
+
+    while (index_[slot] != empty_slot && index_[slot] != tombstone) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+
+    if (index_[slot] == empty_slot) {
+        ++used_;
+    }
+
+    index_[slot] = static_cast<hash_heights::slot>(position);
+}
+
+void hash_heights::compact() {
+    auto const erased = [](entry const& item) {
+        return item.erased;
+    };
+
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(), erased), entries_.end());
+    front_ = 0;
+    rebuild(index_.size());
+}
+
+void hash_heights::rebuild(size_t capacity) {
+    // Size the index for twice the entries, so it remains at most half full.
+    capacity = std::max({ capacity, minimum_capacity, (entries_.size() - front_) * 2 });
+
+    // Round up to a power of two.
+    size_t power = minimum_capacity;
+    while (power < capacity) {
+        power *= 2;
+    }
+
+    index_.assign(power, empty_slot);
+    used_ = 0;
+
+    for (auto position = front_; position < entries_.size(); ++position) {
+        if (entries_[position].erased) {
+            continue;
+        }
+
+        auto slot = bucket(entries_[position].hash, power);
+
+        while (index_[slot] != empty_slot) {
+            slot = (slot + 1) & (power - 1);
+        }
+
+        index_[slot] = static_cast<hash_heights::slot>(position);
+        ++used_;
+    }
+}
+
+} // namespace kth::node
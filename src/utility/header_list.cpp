@@ -17,14 +17,27 @@ using namespace kth::domain::config;
 
 // Locking is optimized for a single intended caller.
 header_list::header_list(size_t slot, infrastructure::config::checkpoint const& start, infrastructure::config::checkpoint const& stop)
-    : height_(*safe_add(start.height(), size_t(1)))
+    : target_(stop.height())
+    , height_(*safe_add(start.height(), size_t(1)))
     , start_(start)
     , stop_(stop)
     , slot_(slot)
+    , tail_(false)
 {
     list_.reserve(*safe_subtract(stop.height(), start.height()));
 }
 
+// The target is unknown until set from a peer, the tail is incomplete.
+// A null stop hash requests the maximum number of headers from the peer.
+header_list::header_list(size_t slot, infrastructure::config::checkpoint const& start)
+    : target_(max_size_t)
+    , height_(*safe_add(start.height(), size_t(1)))
+    , start_(start)
+    , stop_(null_hash, 0)
+    , slot_(slot)
+    , tail_(true)
+{}
+
 bool header_list::complete() const {
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section.
@@ -34,6 +47,19 @@ bool header_list::complete() const {
     ///////////////////////////////////////////////////////////////////////////
 }
 
+bool header_list::tail() const {
+    return tail_;
+}
+
+void header_list::set_target(size_t height) {
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section.
+    unique_lock lock(mutex_);
+
+    target_ = height;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 size_t header_list::slot() const {
     return slot_;
 }
@@ -120,8 +146,9 @@ bool header_list::merge(headers_const_ptr message) {
 //-----------------------------------------------------------------------------
 
 size_t header_list::remaining() const {
-    // This difference is safe from underflow.
-    return list_.capacity() - list_.size();
+    // This addition is safe.
+    auto const height = start_.height() + list_.size();
+    return target_ > height ? target_ - height : 0;
 }
 
 bool header_list::link(const domain::chain::header& header) const {
@@ -146,8 +173,8 @@ bool header_list::accept(const header& header) const {
     //// work_required and median_time_past, however checkpoints are verified.
     ////return !header.accept(...);
 
-    // Verify last checkpoint.
-    return remaining() > 1 || header.hash() == stop_.hash();
+    // Verify last checkpoint, the tail is anchored only by its start.
+    return tail_ || remaining() > 1 || header.hash() == stop_.hash();
 }
 
 } // namespace kth::node
@@ -0,0 +1,342 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/import_queue.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace kth::node {
+
+import_queue::import_queue(size_t capacity, bool require_checks, uint64_t memory)
+    : capacity_(capacity)
+    , require_checks_(require_checks)
+    , memory_limit_(memory)
+    , stopped_(true)
+    , drained_(false)
+    , cursor_(0)
+    , memory_(0)
+{}
+
+bool import_queue::empty() const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.empty();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t import_queue::size() const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool import_queue::full() const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size() >= capacity_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+uint64_t import_queue::memory() const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool import_queue::spill(size_t height, uint64_t size) const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The block for the import cursor is never spilled.
+    if (height <= cursor_) {
+        return false;
+    }
+
+    return memory_ + size > memory_limit_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool import_queue::start(size_t height) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if ( ! stopped_) {
+        return false;
+    }
+
+    stopped_ = false;
+    drained_ = false;
+    cursor_ = height;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void import_queue::stop() {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    ready_.notify_all();
+}
+
+bool import_queue::push(block_const_ptr block, size_t height, std::shared_ptr<reservation> row) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (stopped_ || height < cursor_) {
+            return false;
+        }
+
+        entry value{ std::move(block), height, std::move(row) };
+        value.checked = ! require_checks_;
+        value.size = value.block->serialized_size();
+
+        if ( ! entries_.emplace(height, std::move(value)).second) {
+            return false;
+        }
+
+        memory_ += entries_[height].size;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The importer, the prefetcher and the checkers may be waiting.
+    ready_.notify_all();
+    return true;
+}
+
+bool import_queue::push(hash_digest const& hash, size_t height, uint64_t size, uint64_t offset, std::shared_ptr<reservation> row) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (stopped_ || height < cursor_) {
+            return false;
+        }
+
+        // A spilled block is checked once loaded, as the checker loads it.
+        entry value{ nullptr, height, std::move(row) };
+        value.spilled = true;
+        value.hash = hash;
+        value.size = size;
+        value.offset = offset;
+
+        if ( ! entries_.emplace(height, std::move(value)).second) {
+            return false;
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    ready_.notify_all();
+    return true;
+}
+
+bool import_queue::pop(entry& out_entry) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    ready_.wait(lock, [this]() {
+        return poppable() || (stopped_ && ! queued());
+    });
+
+    // Stopped, blocks are drained up to the first missing height.
+    if ( ! poppable()) {
+        drained_ = true;
+        lock.unlock();
+
+        // The checkers may be waiting on blocks that will not be imported.
+        ready_.notify_all();
+        return false;
+    }
+
+    auto const it = entries_.begin();
+    out_entry = std::move(it->second);
+    erase(it);
+    lock.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The prefetch window has advanced.
+    ready_.notify_all();
+    return true;
+}
+
+void import_queue::imported(size_t height) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cursor_ = height + 1;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The block at the new cursor may already be queued.
+    ready_.notify_all();
+}
+
+bool import_queue::prefetch(list& out, size_t count) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    ready_.wait(lock, [this, count]() {
+        return stopped_ || prefetchable(count);
+    });
+
+    if (stopped_) {
+        return false;
+    }
+
+    auto it = entries_.begin();
+
+    for (size_t index = 0; index < count && it != entries_.end(); ++index, ++it) {
+        if ( ! it->second.prefetched && ! it->second.spilled) {
+            it->second.prefetched = true;
+            out.push_back(it->second);
+        }
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool import_queue::check(entry& out_entry) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Blocks queued before stop are still checked, so that they drain. A
+    // spilled block may be waiting on memory or the cursor, so a checker
+    // exits only once no block remains to check or the import has ended.
+    ready_.wait(lock, [this]() {
+        return drained_ || next_unchecked() != entries_.end() ||
+            (stopped_ && ! unchecked());
+    });
+
+    // Once pop has failed no further block is imported, so none is checked.
+    auto const it = drained_ ? entries_.end() : next_unchecked();
+
+    if (it == entries_.end()) {
+        return false;
+    }
+
+    // The memory of a spilled block is counted as it is loaded.
+    if (it->second.spilled) {
+        memory_ += it->second.size;
+    }
+
+    it->second.checking = true;
+    out_entry = it->second;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void import_queue::checked(size_t height, bool valid, block_const_ptr loaded) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto const it = entries_.find(height);
+
+        if (it == entries_.end()) {
+            return;
+        }
+
+        if (loaded) {
+            it->second.block = std::move(loaded);
+            it->second.spilled = false;
+        }
+
+        if (valid) {
+            it->second.checked = true;
+        } else {
+            erase(it);
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The cursor block may now be popped.
+    ready_.notify_all();
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+// Blocks below the cursor are not accepted, so it is the lowest if queued.
+bool import_queue::queued() const {
+    return ! entries_.empty() && entries_.begin()->first == cursor_;
+}
+
+bool import_queue::poppable() const {
+    return queued() && entries_.begin()->second.checked;
+}
+
+bool import_queue::unchecked() const {
+    for (auto const& item: entries_) {
+        if ( ! item.second.checked && ! item.second.checking) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::map<size_t, import_queue::entry>::iterator import_queue::next_unchecked() {
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        auto const& value = it->second;
+
+        if (value.checked || value.checking) {
+            continue;
+        }
+
+        // The cursor block is loaded regardless of memory, so it progresses.
+        if (value.spilled && it->first != cursor_ && memory_ + value.size > memory_limit_) {
+            continue;
+        }
+
+        return it;
+    }
+
+    return entries_.end();
+}
+
+// A spilled block not taken for check holds no memory.
+std::map<size_t, import_queue::entry>::iterator import_queue::erase(std::map<size_t, import_queue::entry>::iterator it) {
+    if ( ! it->second.spilled || it->second.checking) {
+        memory_ -= it->second.size;
+    }
+
+    return entries_.erase(it);
+}
+
+bool import_queue::prefetchable(size_t count) const {
+    auto it = entries_.begin();
+
+    for (size_t index = 0; index < count && it != entries_.end(); ++index, ++it) {
+        if ( ! it->second.prefetched && ! it->second.spilled) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace kth::node
@@ -4,11 +4,14 @@
 
 #include <kth/node/utility/reservation.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <utility>
+#include <vector>
 // #include <boost/format.hpp>
 
 #define FMT_HEADER_ONLY 1
@@ -36,14 +39,27 @@ static constexpr float multiple = 1.01f;
 // The minimum amount of block history to move the state from idle.
 static constexpr size_t minimum_history = 3;
 
+// The maximum amount of block history, the oldest record is overwritten.
+// This bounds the cost of a rate window in which many blocks are imported.
+static constexpr size_t maximum_history = 4096;
+
+// The bounds of the number of blocks requested of a peer at any time.
+static constexpr size_t minimum_window = 16;
+static constexpr size_t maximum_window = 1024;
+
 // Simple conversion factor, since we trace in micro and report in seconds.
 static constexpr size_t micro_per_second = 1000 * 1000;
 
 reservation::reservation(reservations& reservations, size_t slot, uint32_t sync_timeout_seconds)
     : rate_({ true, 0, 0, 0 })
+    , history_(maximum_history)
+    , history_first_(0)
+    , history_count_(0)
+    , history_events_(0)
+    , history_database_(0)
     , stopped_(false)
+    , retired_(false)
     , pending_(true)
-    , partitioned_(false)
     , reservations_(reservations)
     , slot_(slot)
     , rate_window_(minimum_history * sync_timeout_seconds * micro_per_second)
@@ -92,10 +108,13 @@ bool reservation::idle() const {
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// The table statistics are updated under the rate lock, so that successive
+// changes to the rate of this row are applied to the statistics in order.
 void reservation::set_rate(performance&& rate) {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(rate_mutex_);
+    reservations_.update_rates(rate_, rate);
     rate_ = std::move(rate);
     ///////////////////////////////////////////////////////////////////////////
 }
@@ -139,10 +158,22 @@ void reservation::clear_history() {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(history_mutex_);
-    history_.clear();
+    history_first_ = 0;
+    history_count_ = 0;
+    history_events_ = 0;
+    history_database_ = 0;
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Remove the oldest record, history mutex must be locked.
+void reservation::pop_history() {
+    auto const& record = history_[history_first_];
+    history_events_ -= record.events;
+    history_database_ -= record.database;
+    history_first_ = (history_first_ + 1) % history_.size();
+    --history_count_;
+}
+
 // It is possible to get a rate update after idling and before starting anew.
 // This can reduce the average during startup of the new channel until start.
 void reservation::update_rate(size_t events, const microseconds& database) {
@@ -154,32 +185,43 @@ void reservation::update_rate(size_t events, const microseconds& database) {
     auto const end = now();
     auto const event_start = end - microseconds(database);
     auto const start = end - rate_window();
-    auto const history_count = history_.size();
+    auto const history_count = history_count_;
 
     // Remove expired entries from the head of the queue.
-    for (auto it = history_.begin(); it != history_.end() && it->time < start; it = history_.erase(it));
+    while (history_count_ != 0 && history_[history_first_].time < start) {
+        pop_history();
+    }
+
+    auto const window_full = history_count > history_count_;
+
+    // Overwrite the oldest record if the buffer is full.
+    if (history_count_ == history_.size()) {
+        pop_history();
+    }
 
-    auto const window_full = history_count > history_.size();
     auto const event_cost = static_cast<uint64_t>(database.count());
-    history_.push_back({ events, event_cost, event_start });
+    auto const last = (history_first_ + history_count_++) % history_.size();
+    history_[last] = { events, event_cost, event_start };
+
+    // Maintain the summary of event count and database cost.
+    KTH_ASSERT(history_events_ <= max_size_t - events);
+    history_events_ += events;
+    KTH_ASSERT(history_database_ <= max_uint64 - event_cost);
+    history_database_ += event_cost;
 
     // We can't set the rate until we have a period (two or more data points).
-    if (history_.size() < minimum_history) {
+    if (history_count_ < minimum_history) {
         history_mutex_.unlock();
         //---------------------------------------------------------------------
         return;
     }
 
-    // Summarize event count and database cost.
-    for (auto const& record: history_) {
-        KTH_ASSERT(rate.events <= max_size_t - record.events);
-        rate.events += record.events;
-        KTH_ASSERT(rate.database <= max_uint64 - record.database);
-        rate.database += record.database;
-    }
+    rate.events = history_events_;
+    rate.database = history_database_;
 
     // Calculate the duration of the rate window.
-    auto window = window_full ? rate_window() : (end - history_.front().time);
+    auto const oldest = history_[history_first_].time;
+    auto window = window_full ? rate_window() : (end - oldest);
     auto count = duration_cast<microseconds>(window).count();
     rate.window = static_cast<uint64_t>(count);
 
@@ -224,7 +266,39 @@ bool reservation::stopped() const {
     ///////////////////////////////////////////////////////////////////////////
 }
 
-// Obtain and clear the outstanding blocks request.
+bool reservation::retired() const {
+    // Critical Section (stop)
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(stop_mutex_);
+    return retired_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void reservation::retire() {
+    // Critical Section (stop)
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(stop_mutex_);
+    retired_ = true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The number of blocks from the height the peer is expected to deliver
+// within the timeout. The rate is in bytes, so blocks are estimated by size.
+size_t reservation::window(size_t height) const {
+    auto const record = rate();
+
+    if (record.idle) {
+        return minimum_window;
+    }
+
+    auto const timeout = rate_window().count() / minimum_history;
+    auto const bytes = record.normal() * timeout;
+    auto const size = reservations_.estimate(height);
+    auto const expected = static_cast<size_t>(bytes / size);
+    return std::clamp(expected, minimum_window, maximum_window);
+}
+
+// Obtain the request for the next window of outstanding blocks.
 domain::message::get_data reservation::request(bool new_channel) {
     domain::message::get_data packet;
 
@@ -235,27 +309,44 @@ domain::message::get_data reservation::request(bool new_channel) {
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    hash_mutex_.lock_upgrade();
+    unique_lock lock(hash_mutex_);
 
-    if ( ! new_channel && ! pending_) {
-        hash_mutex_.unlock_upgrade();
-        //---------------------------------------------------------------------
+    size_t first = 0;
+    heights_.front(1, [&first](hash_digest const&, size_t height) {
+        first = height;
+    });
+
+    auto const limit = window(first);
+
+    // Blocks requested of a preceding channel must be requested again.
+    if (new_channel) {
+        heights_.reset_requested();
+        pending_ = ! heights_.empty();
+    }
+
+    // Top up once half of the window has been received.
+    auto const requested = heights_.requested();
+
+    if ( ! pending_ || requested > limit / 2) {
         return packet;
     }
 
-    // Build get_blocks request message.
-    for (auto height = heights_.right.begin(); height != heights_.right.end(); ++height) {
-        static auto const id = domain::message::inventory::type_id::block;
-        packet.inventories().emplace_back(id, height->second);
+    // Defer the request while the importer is behind, retaining it as pending.
+    if (reservations_.saturated()) {
+        return packet;
     }
 
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    hash_mutex_.unlock_upgrade_and_lock();
-    pending_ = false;
-    hash_mutex_.unlock();
-    ///////////////////////////////////////////////////////////////////////////
+    // Build get_blocks request message.
+    static auto const id = domain::message::inventory::type_id::block;
+    packet.inventories().reserve(limit - requested);
+
+    heights_.request(limit - requested, [&packet](hash_digest const& hash, size_t) {
+        packet.inventories().emplace_back(id, hash);
+    });
 
+    pending_ = heights_.requested() < heights_.size();
     return packet;
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 void reservation::insert(hash_digest&& hash, size_t height) {
@@ -264,7 +355,27 @@ void reservation::insert(hash_digest&& hash, size_t height) {
     unique_lock lock(hash_mutex_);
 
     pending_ = true;
-    heights_.insert({ std::move(hash), height });
+    heights_.insert(hash, height);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Called when empty, but a restored hash may have been inserted since the
+// emptiness check, so the heights are merged unless there are none.
+void reservation::insert(hash_heights&& heights) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(hash_mutex_);
+
+    pending_ = true;
+
+    if (heights_.empty()) {
+        heights_ = std::move(heights);
+        return;
+    }
+
+    heights.for_each([this](hash_digest const& hash, size_t height) {
+        heights_.insert(hash, height);
+    });
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -274,13 +385,34 @@ void reservation::import(block_const_ptr block) {
     auto const hash = block->header().hash();
     auto const encoded = encode_hash(hash);
 
-    if ( ! find_height_and_erase(hash, height)) {
+    // The block may have been requested before its height was partitioned.
+    if ( ! find_height_and_erase(hash, height) &&
+        ! reservations_.find_height_and_erase(hash, height)) {
         LOG_DEBUG(LOG_NODE
            , "Ignoring unsolicited block (", slot(), ") ["
            , encoded, "]");
+
+        // This may be the loser of a duplicated request.
+        populate();
         return;
     }
 
+    // Other copies of a duplicated request are cancelled.
+    reservations_.cancel(hash);
+
+    // The importer imports the block and updates the rate of this row.
+    if ( ! reservations_.enqueue(block, height, shared_from_this())) {
+        LOG_DEBUG(LOG_NODE
+           , "Stopped before queueing block (", slot(), ") ["
+           , encoded, "]");
+    }
+
+    populate();
+}
+
+bool reservation::store(block_const_ptr block, size_t height) {
+    auto const encoded = encode_hash(block->header().hash());
+
     bool success;
     auto const importer = [this, &block, &height, &success]() {
         success = reservations_.import(block, height);
@@ -290,8 +422,8 @@ void reservation::import(block_const_ptr block) {
     auto const cost = timer<microseconds>::duration(importer);
 
     if (success) {
-        static auto const unit_size = 1u;
-        update_rate(unit_size, cost);
+        // The rate is measured in bytes, so that heavy ranges are not slow.
+        update_rate(block->serialized_size(), cost);
         auto const record = rate();
         auto formatted = fmt::format("Imported block #%06i (%02i) [%s] %06.2f %05.2f%%",
             height, slot(), encoded, record.total() * micro_per_second, record.ratio() * 100);
@@ -302,15 +434,14 @@ void reservation::import(block_const_ptr block) {
         //    , boost::format(formatter) % height % slot() % encoded %
         //     (record.total() * micro_per_second) % (record.ratio() * 100));
     } else {
-        // This could also result from a block import failure resulting from
-        // inserting at a height that is already populated, but that should be
-        // precluded by the implementation. This is the only other failure.
-        LOG_DEBUG(LOG_NODE
-           , "Stopped before importing block (", slot(), ") ["
+        // Blocks are imported in height order, so no block above this one
+        // can be imported.
+        LOG_ERROR(LOG_NODE
+           , "Failure importing block #", height, " (", slot(), ") ["
            , encoded, "]");
     }
 
-    populate();
+    return success;
 }
 #endif // ! defined(KTH_DB_READONLY)
 
@@ -323,7 +454,9 @@ void reservation::populate() {
     if ( ! stopped_ && empty()) {
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
         stop_mutex_.unlock_upgrade_and_lock();
-        stopped_ = !reservations_.populate(shared_from_this());
+
+        // A retired row completes its hashes but does not take more.
+        stopped_ = retired_ || !reservations_.populate(shared_from_this());
         stop_mutex_.unlock();
         //---------------------------------------------------------------------
         return;
@@ -333,100 +466,94 @@ void reservation::populate() {
     ///////////////////////////////////////////////////////////////////////////
 }
 
-bool reservation::toggle_partitioned() {
+void reservation::lowest(size_t count, infrastructure::config::checkpoint::list& out) const {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    hash_mutex_.lock_upgrade();
-
-    if (partitioned_) {
-        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-        hash_mutex_.unlock_upgrade_and_lock();
-        partitioned_ = false;
-        pending_ = true;
-        hash_mutex_.unlock();
-        //---------------------------------------------------------------------
-        return true;
-    }
+    shared_lock lock(hash_mutex_);
 
-    hash_mutex_.unlock_upgrade();
+    heights_.front(count, [&out](hash_digest const& hash, size_t height) {
+        out.emplace_back(hash, height);
+    });
     ///////////////////////////////////////////////////////////////////////////
-
-    return false;
 }
 
-// Give the minimal row ~ half of our hashes, return false if minimal is empty.
+// Give the minimal row the upper half of our hashes by estimated bytes, false
+// if none taken.
+// The lower heights are left in place, as they are the most likely to have
+// been requested, so this channel continues without restart.
 bool reservation::partition(reservation::ptr minimal) {
-    // This assumes that partition has been called under a table mutex.
     if ( ! minimal->empty()) {
         return true;
     }
 
+    std::vector<size_t> heights;
+
     // Critical Section (hash)
     ///////////////////////////////////////////////////////////////////////////
-    hash_mutex_.lock_upgrade();
+    {
+        shared_lock lock(hash_mutex_);
+        heights.reserve(heights_.size());
+
+        heights_.for_each([&heights](hash_digest const&, size_t height) {
+            heights.push_back(height);
+        });
+    }
+    ///////////////////////////////////////////////////////////////////////////
 
-    // This addition is safe.
-    // Take half of the maximal reservation, rounding up to get last entry.
-    auto const offset = (heights_.size() + 1u) / 2u;
-    auto it = heights_.right.begin();
+    if (heights.size() < 2) {
+        return false;
+    }
 
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    hash_mutex_.unlock_upgrade_and_lock();
+    // Each estimate locks the block sizes, so bytes are summed without the
+    // hash lock, as a running total by increasing height.
+    std::vector<uint64_t> bytes;
+    bytes.reserve(heights.size());
+    uint64_t total = 0;
 
-    // TODO: move the range in a single command.
-    for (size_t index = 0; index < offset; ++index) {
-        minimal->heights_.right.insert(std::move(*it));
-        it = heights_.right.erase(it);
+    for (auto const height: heights) {
+        total += reservations_.estimate(height);
+        bytes.push_back(total);
     }
 
-    partitioned_ = !heights_.empty();
-    auto const populated = !minimal->empty();
-    minimal->pending_ = populated;
+    // Keep the lowest entries up to half of the estimated bytes, at least one.
+    auto const half = std::lower_bound(bytes.begin(), bytes.end(), total / 2u);
+    auto const kept = static_cast<size_t>(std::distance(bytes.begin(), half)) + 1;
+    auto const count = heights.size() - std::min(kept, heights.size());
 
-    if ( ! partitioned_) {
-        // Critical Section (stop)
-        ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(stop_mutex_);
+    hash_heights stolen;
 
-        // If the channel has been emptied it will not repopulate.
-        stopped_ = true;
-        ///////////////////////////////////////////////////////////////////////
+    // Critical Section (hash)
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(hash_mutex_);
+
+        // Entries imported since the copy are the lowest, so the highest
+        // count remain those above the split, leaving any single entry.
+        if (heights_.size() > 1) {
+            heights_.move_back(stolen, std::min(count, heights_.size() - 1));
+        }
     }
-
-    hash_mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
-    if (populated) {
-        LOG_DEBUG(LOG_NODE
-           , "Moved [", minimal->size(), "] blocks from slot (", slot()
-           , ") to (", minimal->slot(), ") leaving [", size(), "].");
+    if (stolen.empty()) {
+        return false;
     }
 
-    return populated;
+    minimal->insert(std::move(stolen));
+
+    LOG_DEBUG(LOG_NODE
+       , "Moved [", minimal->size(), "] blocks from slot (", slot()
+       , ") to (", minimal->slot(), ") leaving [", size(), "].");
+
+    return true;
 }
 
 bool reservation::find_height_and_erase(hash_digest const& hash, size_t& out_height) {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    hash_mutex_.lock_upgrade();
-
-    auto const it = heights_.left.find(hash);
-
-    if (it == heights_.left.end()) {
-        hash_mutex_.unlock_upgrade();
-        //---------------------------------------------------------------------
-        return false;
-    }
-
-    out_height = it->second;
-
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    hash_mutex_.unlock_upgrade_and_lock();
-    heights_.left.erase(it);
-    hash_mutex_.unlock();
+    unique_lock lock(hash_mutex_);
+    return heights_.find_and_erase(hash, out_height);
     ///////////////////////////////////////////////////////////////////////////
-
-    return true;
 }
 
 } // namespace kth::node
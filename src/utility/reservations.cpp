@@ -7,10 +7,16 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <filesystem>
+#include <future>
+#include <iterator>
 #include <memory>
-#include <numeric>
+#include <random>
+#include <string>
 #include <utility>
 #include <vector>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
 #include <kth/domain.hpp>
 #include <kth/node/define.hpp>
 #include <kth/node/utility/check_list.hpp>
@@ -19,71 +25,475 @@
 
 namespace kth::node {
 
+using namespace std::chrono;
 using namespace kth::blockchain;
 using namespace kth::domain::chain;
 
-reservations::reservations(check_list& hashes, fast_chain& chain, settings const& settings)
+// The number of downloaded blocks awaiting import at which requests defer.
+static constexpr size_t import_capacity = 256;
+
+// The estimated block size before the size of any block is known.
+static constexpr uint64_t default_block_size = 250000;
+
+// The maximum estimated bytes of a reservation, in addition to max_request.
+static constexpr uint64_t maximum_bytes = 256 * 1024 * 1024;
+
+// The number of threads checking queued blocks, if concurrency is unknown.
+static constexpr size_t default_checkers = 2;
+
+// The number of lowest queued blocks read ahead of import.
+static constexpr size_t prefetch_blocks = 16;
+
+// The number of prefetched inputs between reports of the hit rate.
+static constexpr uint64_t prefetch_report = 1000000;
+
+// The number of imported blocks between records of the import height.
+static constexpr size_t state_interval = 1000;
+
+// The number of rows created at start, rows are added up to sync_peers.
+static constexpr size_t initial_rows = 3;
+
+// The relative gain in throughput required to retain an added row.
+static constexpr double minimum_gain = 0.05;
+
+// The number of regulator calls skipped after a row is retired.
+static constexpr size_t retire_backoff = 6;
+
+// The number of outstanding hashes duplicated to an empty row in endgame.
+static constexpr size_t endgame_size = 16;
+
+// The number of regulator calls without an import after which the lowest
+// outstanding hashes are duplicated to the fastest row.
+static constexpr size_t stall_intervals = 2;
+
+// The height of the last checkpoint, headers above it are not anchored.
+static size_t last_checkpoint(blockchain::settings const& settings) {
+    size_t height = 0;
+
+    for (auto const& checkpoint: settings.checkpoints) {
+        height = std::max(height, checkpoint.height());
+    }
+
+    return height;
+}
+
+// A unique temporary path, so that nodes may share the temporary directory.
+static std::filesystem::path spill_path() {
+    std::random_device random;
+    auto const name = "kth_sync_" + std::to_string(random()) + ".spill";
+    return std::filesystem::temp_directory_path() / name;
+}
+
+// The memory budget of queued blocks, unlimited if not configured.
+static uint64_t memory_budget(settings const& settings) {
+    return settings.sync_memory_megabytes == 0 ? max_uint64 :
+        uint64_t(settings.sync_memory_megabytes) * 1024 * 1024;
+}
+
+reservations::reservations(check_list& hashes, sync_state& state, block_chain& chain, settings const& settings)
     : hashes_(hashes)
+    , sizes_(default_block_size)
     , max_request_(max_get_data)
+    , next_slot_(0)
+    , imported_bytes_(0)
+    , failed_(false)
+    , rejected_(false)
     , timeout_(settings.sync_timeout_seconds)
+    , maximum_rows_(settings.sync_peers)
+    , memory_(memory_budget(settings))
+    , first_(hashes.first())
+    , checkpoint_(last_checkpoint(chain.chain_settings()))
+    , regulated_imported_(0)
+    , regulated_rate_(0)
+    , backoff_(0)
+    , stalled_(0)
+    , added_(false)
     , chain_(chain)
+    , state_(state)
+    , queue_(import_capacity, true, memory_)
+    , spill_(spill_path())
+    , prefetched_(0)
+    , prefetch_hits_(0)
+    , rates_count_(0)
+    , rates_mean_(0)
+    , rates_squares_(0)
+    , active_count_(0)
+    , arithmetic_mean_(0)
+    , standard_deviation_(0)
 {
-    initialize(std::min(settings.sync_peers, 3u));
+    initialize(std::min(maximum_rows_, initial_rows));
 }
 
+reservations::~reservations() {
+    stop();
+}
+
+// Not thread safe with respect to stop, both are called from the session.
 bool reservations::start() {
+    // Blocks are imported from the first height of the hash list.
+    if ( ! queue_.start(first_)) {
+        return false;
+    }
+
+    // Without the spill file, blocks are held in memory beyond the budget.
+    if (memory_ != max_uint64 && ! spill_.open()) {
+        LOG_WARNING(LOG_NODE
+           , "Failed to create the sync spill file, queued blocks are held in memory.");
+    }
+
+    importer_ = std::thread([this]() {
+        drain();
+    });
+
+    prefetcher_ = std::thread([this]() {
+        prefetch();
+    });
+
+    auto const cores = std::thread::hardware_concurrency();
+    auto const checkers = cores == 0 ? default_checkers : size_t(cores);
+
+    for (size_t index = 0; index < checkers; ++index) {
+        checkers_.emplace_back([this]() {
+            check();
+        });
+    }
+
+    regulated_ = std::chrono::steady_clock::now();
+
     return true;
 }
 
 #if ! defined(KTH_DB_READONLY)
+// Headers above the last checkpoint are only linked and checked for proof of
+// work, so their blocks are fully validated, as if announced once running.
 bool reservations::import(block_const_ptr block, size_t height) {
     //#########################################################################
-    return chain_.insert(block, height);
+    auto const inserted = height > checkpoint_ ? organize(block, height) :
+        chain_.insert(block, height);
     //#########################################################################
+
+    if (inserted) {
+        auto const size = block->serialized_size();
+        sizes_.record(height, size);
+        imported_bytes_ += size;
+        queue_.imported(height);
+
+        // Resume scans the store above the recorded height, so it may lag.
+        if ((height + 1) % state_interval == 0 && ! state_.set_import_height(height + 1)) {
+            LOG_DEBUG(LOG_NODE, "Import height [", height + 1, "] not persisted.");
+        }
+    }
+
+    return inserted;
+}
+
+// The importer is the only caller, so blocks are organized in height order.
+bool reservations::organize(block_const_ptr block, size_t height) {
+    std::promise<code> promise;
+
+    chain_.organize(block, [&promise](code const& ec) {
+        promise.set_value(ec);
+    });
+
+    auto const ec = promise.get_future().get();
+
+    if (ec) {
+        LOG_WARNING(LOG_NODE
+           , "Rejected block #", height, " above the last checkpoint ["
+           , encode_hash(block->header().hash()), "] ", ec.message());
+    }
+
+    return ! ec;
+}
+
+// Checks that do not depend on the chain state run on all cores, so only
+// the connect and store of each block remain sequential on the importer.
+void reservations::check() {
+    import_queue::entry entry;
+
+    while (queue_.check(entry)) {
+        block_const_ptr loaded;
+
+        if (entry.spilled) {
+            loaded = load(entry);
+            spill_.release(entry.offset, entry.size);
+            entry.block = loaded;
+        }
+
+        auto const valid = entry.block && check(*entry.block);
+        queue_.checked(entry.height, valid, loaded);
+
+        if ( ! valid) {
+            auto const hash = entry.block ? entry.block->header().hash() : entry.hash;
+            LOG_WARNING(LOG_NODE
+               , "Invalid block #", entry.height, " (", entry.row->slot(), ") ["
+               , encode_hash(hash), "], requesting it again.");
+
+            restore(hash_digest(hash), entry.height, entry.row);
+        }
+
+        entry = {};
+    }
+}
+
+// A matching merkle root does not bind the transactions to the block hash, as
+// duplicating trailing transactions preserves it (CVE-2012-2459). So all
+// context free checks are run, which also reject duplicated transactions.
+bool reservations::check(domain::chain::block const& block) const {
+    auto const ec = block.check(block.serialized_size(false));
+
+    if (ec) {
+        LOG_DEBUG(LOG_NODE
+           , "Block [", encode_hash(block.hash()), "] failed check: "
+           , ec.message());
+    }
+
+    return ! ec;
+}
+
+// The block is parsed directly from the mapped file, without a copy.
+block_const_ptr reservations::load(import_queue::entry const& entry) const {
+    block_const_ptr block;
+
+    auto const parse = [&block](uint8_t const* data, size_t size) {
+        using namespace boost::iostreams;
+        using namespace kth::domain::message;
+        stream<array_source> source(reinterpret_cast<char const*>(data), size);
+        auto const value = std::make_shared<domain::message::block>(
+            domain::message::block::factory_from_data(version::level::canonical, source));
+
+        if (value->is_valid()) {
+            block = value;
+        }
+    };
+
+    if ( ! spill_.load(entry.offset, entry.size, parse) || ! block) {
+        LOG_ERROR(LOG_NODE
+           , "Failed to load spilled block #", entry.height, ".");
+    }
+
+    return block;
+}
+
+// A stopped row has completed its channel, so the hash must go to a live row.
+// The import cursor is held at the height until the block is replaced, so if
+// there is no live row to request it, the import cannot complete.
+void reservations::restore(hash_digest&& hash, size_t height, reservation::ptr row) {
+    if ( ! row->stopped()) {
+        row->insert(std::move(hash), height);
+        return;
+    }
+
+    for (auto const& other: table()) {
+        if ( ! other->stopped()) {
+            other->insert(std::move(hash), height);
+            return;
+        }
+    }
+
+    LOG_ERROR(LOG_NODE
+       , "No active row to request block #", height, " again.");
+
+    failed_ = true;
+    queue_.stop();
+}
+
+// While the importer connects the lowest blocks, the previous outputs of the
+// next queued blocks are read, so their store pages are cached on connect.
+void reservations::prefetch() {
+    import_queue::list blocks;
+
+    while (queue_.prefetch(blocks, prefetch_blocks)) {
+        for (auto const& entry: blocks) {
+            prefetch(*entry.block, entry.height);
+        }
+
+        blocks.clear();
+    }
+}
+
+void reservations::prefetch(domain::chain::block const& block, size_t height) {
+    auto const& transactions = block.transactions();
+    uint64_t inputs = 0;
+    uint64_t hits = 0;
+
+    if (transactions.empty()) {
+        return;
+    }
+
+    // The coinbase has no previous output.
+    for (auto tx = std::next(transactions.begin()); tx < transactions.end(); ++tx) {
+        for (auto const& input: tx->inputs()) {
+            ++inputs;
+
+            // A miss is an output created in a block not yet imported.
+            if (chain_.get_utxo(input.previous_output(), height).is_valid()) {
+                ++hits;
+            }
+        }
+    }
+
+    prefetch_hits_ += hits;
+    auto const previous = prefetched_.fetch_add(inputs);
+
+    if ((previous + inputs) / prefetch_report != previous / prefetch_report) {
+        LOG_DEBUG(LOG_NODE
+           , "Prefetched ", previous + inputs, " inputs with hit rate "
+           , prefetch_hit_rate() * 100, "%.");
+    }
+}
+
+// Blocks far above the import cursor are written to the spill file once the
+// memory budget is reached, so that many sync peers do not exhaust memory.
+bool reservations::enqueue(block_const_ptr block, size_t height, reservation::ptr row) {
+    if (queue_.spill(height, block->serialized_size())) {
+        uint64_t offset;
+        auto const data = block->to_data(domain::message::version::level::canonical);
+
+        if (spill_.store(data, offset)) {
+            auto const hash = block->header().hash();
+
+            if (queue_.push(hash, height, data.size(), offset, std::move(row))) {
+                return true;
+            }
+
+            spill_.release(offset, data.size());
+            return false;
+        }
+
+        // The block is held in memory if it cannot be spilled.
+    }
+
+    return queue_.push(std::move(block), height, std::move(row));
 }
 #endif //! defined(KTH_DB_READONLY)
 
+uint64_t reservations::estimate(size_t height) const {
+    return sizes_.estimate(height);
+}
+
+double reservations::prefetch_hit_rate() const {
+    return divide<double>(prefetch_hits_.load(), prefetched_.load());
+}
+
+bool reservations::saturated() const {
+    return queue_.full();
+}
+
+// The block at the import cursor is imported first, so a slow store does not
+// stall network reads and blocks may arrive out of order while it completes.
+// A block that fails to store leaves a gap, so the import stops at it, and
+// the next pop fails as the cursor is not advanced, releasing the checkers.
+// A block rejected above the last checkpoint does not fail the sync, as the
+// peers' chain above it is obtained and validated once the node is running.
+// TODO: insert consecutive checkpointed blocks in one store transaction once
+// fast_chain exposes a batched insert, still stopping at the first failure.
+void reservations::drain() {
+    import_queue::entry entry;
+
+    while (queue_.pop(entry)) {
+#if ! defined(KTH_DB_READONLY)
+        if ( ! entry.row->store(entry.block, entry.height)) {
+            if (entry.height > checkpoint_) {
+                rejected_ = true;
+            } else {
+                failed_ = true;
+            }
+
+            queue_.stop();
+        }
+#endif
+        entry = {};
+    }
+}
+
 bool reservations::stop() {
-    return true;
+    queue_.stop();
+
+    if (prefetcher_.joinable()) {
+        prefetcher_.join();
+    }
+
+    if (importer_.joinable()) {
+        importer_.join();
+    }
+
+    for (auto& checker: checkers_) {
+        checker.join();
+    }
+
+    checkers_.clear();
+    spill_.close();
+
+    if (prefetched_ != 0) {
+        LOG_DEBUG(LOG_NODE
+           , "Prefetched ", prefetched_.load(), " inputs with hit rate "
+           , prefetch_hit_rate() * 100, "%.");
+    }
+
+    // Blocks are left queued only above a height that was not imported.
+    return ! failed_ && (rejected_ || queue_.empty());
 }
 
 // Rate methods.
 //-----------------------------------------------------------------------------
 
 // A statistical summary of block import rates.
-// This computation is not synchronized across rows because rates are cached.
+// This is not synchronized across rows because rates are cached. The values
+// are published individually, so may reflect adjacent updates.
 reservations::rate_statistics reservations::rates() const {
-    // Copy row pointer table to prevent need for lock during iteration.
-    auto rows = table();
-    auto const idle = [](reservation::ptr row) {
-        return row->idle();
-    };
+    return{ active_count_.load(), arithmetic_mean_.load(), standard_deviation_.load() };
+}
+
+void reservations::update_rates(performance const& previous, performance const& current) {
+    if (previous.idle && current.idle) {
+        return;
+    }
 
-    // Remove idle rows from the table.
-    rows.erase(std::remove_if(rows.begin(), rows.end(), idle), rows.end());
-    auto const active_rows = rows.size();
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(rates_mutex_);
 
-    std::vector<double> rates(active_rows);
-    auto const normal_rate = [](reservation::ptr row) {
-        return row->rate().normal();
-    };
+    if ( ! previous.idle) {
+        remove_rate(previous.normal());
+    }
+
+    if ( ! current.idle) {
+        add_rate(current.normal());
+    }
 
-    // Convert to a rates table and sum.
-    std::transform(rows.begin(), rows.end(), rates.begin(), normal_rate);
-    auto const total = std::accumulate(rates.begin(), rates.end(), 0.0);
+    // Rounding may leave the sum of squares marginally negative.
+    rates_squares_ = std::max(rates_squares_, 0.0);
+    auto const quotient = divide<double>(rates_squares_, rates_count_);
 
-    // Calculate mean and sum of deviations.
-    auto const mean = divide<double>(total, active_rows);
-    auto const summary = [mean](double initial, double rate) {
-        auto const difference = mean - rate;
-        return initial + (difference * difference);
-    };
+    active_count_.store(rates_count_);
+    arithmetic_mean_.store(rates_mean_);
+    standard_deviation_.store(std::sqrt(quotient));
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Welford's algorithm, the mean and sum of squared deviations are updated
+// without retaining the individual rates.
+void reservations::add_rate(double rate) {
+    ++rates_count_;
+    auto const difference = rate - rates_mean_;
+    rates_mean_ += difference / rates_count_;
+    rates_squares_ += difference * (rate - rates_mean_);
+}
+
+void reservations::remove_rate(double rate) {
+    KTH_ASSERT(rates_count_ > 0);
 
-    // Calculate the standard deviation in the rate deviations.
-    auto squares = std::accumulate(rates.begin(), rates.end(), 0.0, summary);
-    auto quotient = divide<double>(squares, active_rows);
-    auto standard_deviation = std::sqrt(quotient);
-    return{ active_rows, mean, standard_deviation };
+    // Reset on the last removal, which also discards accumulated rounding.
+    if (--rates_count_ == 0) {
+        rates_mean_ = 0;
+        rates_squares_ = 0;
+        return;
+    }
+
+    auto const difference = rate - rates_mean_;
+    rates_mean_ -= difference / rates_count_;
+    rates_squares_ -= difference * (rate - rates_mean_);
 }
 
 // Table methods.
@@ -117,6 +527,97 @@ void reservations::remove(reservation::ptr row) {
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Regulator methods.
+//-----------------------------------------------------------------------------
+
+bool reservations::regulate() {
+    auto const now = steady_clock::now();
+    auto const imported = imported_bytes_.load();
+    auto const elapsed = duration_cast<microseconds>(now - regulated_).count();
+    auto const rate = divide<double>(imported - regulated_imported_, elapsed);
+    auto const previous = regulated_rate_;
+    auto const added = added_;
+    auto const stalled = imported == regulated_imported_;
+
+    regulated_ = now;
+    regulated_imported_ = imported;
+    regulated_rate_ = rate;
+    added_ = false;
+
+    // A slow row holding the lowest outstanding height stalls the import.
+    if ( ! stalled) {
+        stalled_ = 0;
+    } else if (++stalled_ == stall_intervals) {
+        stalled_ = 0;
+        expedite();
+    }
+
+    if (backoff_ != 0) {
+        --backoff_;
+        return false;
+    }
+
+    // The last added row did not improve throughput, so give one back.
+    if (added && rate < previous * (1.0 + minimum_gain)) {
+        retire_slowest();
+        backoff_ = retire_backoff;
+        return false;
+    }
+
+    // Add rows while hashes remain unreserved, up to the configured peers.
+    auto rows = table();
+    auto const retired = [](reservation::ptr row) {
+        return row->retired();
+    };
+
+    rows.erase(std::remove_if(rows.begin(), rows.end(), retired), rows.end());
+    added_ = ! hashes_.empty() && rows.size() < maximum_rows_;
+    return added_;
+}
+
+reservation::ptr reservations::add() {
+    auto const row = std::make_shared<reservation>(*this, next_slot_++, timeout_);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+    table_.push_back(row);
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    row->populate();
+
+    if (row->stopped()) {
+        remove(row);
+        return nullptr;
+    }
+
+    LOG_DEBUG(LOG_NODE, "Added block slot (", row->slot(), ").");
+    return row;
+}
+
+void reservations::retire_slowest() {
+    auto rows = table();
+    auto const excluded = [](reservation::ptr row) {
+        return row->retired() || row->idle();
+    };
+
+    rows.erase(std::remove_if(rows.begin(), rows.end(), excluded), rows.end());
+
+    if (rows.size() < 2) {
+        return;
+    }
+
+    auto const slower = [](reservation::ptr left, reservation::ptr right) {
+        return left->rate().normal() < right->rate().normal();
+    };
+
+    auto const slowest = *std::min_element(rows.begin(), rows.end(), slower);
+    slowest->retire();
+
+    LOG_DEBUG(LOG_NODE, "Retired block slot (", slowest->slot(), ").");
+}
+
 // Hash methods.
 //-----------------------------------------------------------------------------
 
@@ -137,41 +638,40 @@ void reservations::initialize(size_t connections) {
 
     table_.reserve(rows);
 
-    // Allocate up to 50k headers per row.
-    auto const max_allocation = rows * max_request();
+    // Allocate up to 50k headers or the maximum estimated bytes per row.
+    // Rows take alternating heights, so estimated bytes are evenly divided.
+    // No block size is known at start, so this is a division by count and
+    // only later partitions are weighted by the sizes of imported blocks.
+    auto const first = hashes_.first();
+    auto const max_allocation = sizes_.count(first, rows * max_bytes(), rows * max_request());
     auto const allocation = std::min(blocks, max_allocation);
 
     for (size_t row = 0; row < rows; ++row) {
-        table_.push_back(std::make_shared<reservation>(*this, row, timeout_));
+        table_.push_back(std::make_shared<reservation>(*this, next_slot_++, timeout_));
     }
 
-    size_t height;
-    hash_digest hash;
-
     // The (allocation / rows) * rows cannot exceed allocation.
     // The remainder is retained by the hash list for later reservation.
-    for (size_t base = 0; base < (allocation / rows); ++base) {
-        for (size_t row = 0; row < rows; ++row) {
-            DEBUG_ONLY(auto const result =) hashes_.dequeue(hash, height);
-            KTH_ASSERT_MSG(result, "The checklist is empty.");
-            table_[row]->insert(std::move(hash), height);
-        }
+    check_list::checks checks;
+    auto const count = (allocation / rows) * rows;
+    DEBUG_ONLY(auto const result =) hashes_.dequeue_n(checks, count);
+    KTH_ASSERT_MSG(result == count, "The checklist is empty.");
+
+    for (size_t index = 0; index < checks.size(); ++index) {
+        auto& check = checks[index];
+        table_[index % rows]->insert(hash_digest{ check.hash() }, check.height());
     }
 
     LOG_DEBUG(LOG_NODE, "Reserved ", allocation, " blocks to ", rows, " slots.");
 }
 
 // Call when minimal is empty.
+// The table is locked only to select the maximal row, hashes are then moved
+// under the row locks, so other rows are not stalled by the partition.
 bool reservations::populate(reservation::ptr minimal) {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    mutex_.lock();
-
     // Take from unallocated or allocated hashes, true if minimal not empty.
-    auto const populated = reserve(minimal) || partition(minimal);
-
-    mutex_.unlock();
-    ///////////////////////////////////////////////////////////////////////////
+    auto const populated = reserve(minimal) || partition(minimal) ||
+        endgame(minimal);
 
     if (populated) {
         LOG_DEBUG(LOG_NODE
@@ -188,8 +688,11 @@ bool reservations::partition(reservation::ptr minimal) {
     return maximal && maximal != minimal && maximal->partition(minimal);
 }
 
-reservation::ptr reservations::find_maximal() {
-    if (table_.empty()) {
+reservation::ptr reservations::find_maximal() const {
+    // Copy row pointer table to prevent need for lock during iteration.
+    auto const rows = table();
+
+    if (rows.empty()) {
         return nullptr;
     }
 
@@ -198,7 +701,174 @@ reservation::ptr reservations::find_maximal() {
         return left->size() < right->size();
     };
 
-    return *std::max_element(table_.begin(), table_.end(), comparer);
+    return *std::max_element(rows.begin(), rows.end(), comparer);
+}
+
+// A block requested by a row may since have been moved to another row.
+bool reservations::find_height_and_erase(hash_digest const& hash, size_t& out_height) {
+    for (auto const& row: table()) {
+        if (row->find_height_and_erase(hash, out_height)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Once nothing remains to be reserved or partitioned, the lowest outstanding
+// hashes are also requested by the empty row, the first copy is imported.
+bool reservations::endgame(reservation::ptr minimal) {
+    if ( ! minimal->empty()) {
+        return true;
+    }
+
+    if ( ! hashes_.empty()) {
+        return false;
+    }
+
+    check_list::checks checks;
+
+    for (auto const& row: table()) {
+        if (row != minimal) {
+            row->lowest(endgame_size, checks);
+        }
+    }
+
+    auto const lower = [](auto const& left, auto const& right) {
+        return left.height() < right.height();
+    };
+
+    auto const same = [](auto const& left, auto const& right) {
+        return left.height() == right.height();
+    };
+
+    // Rows may already hold duplicates, each height is taken once.
+    std::sort(checks.begin(), checks.end(), lower);
+    checks.erase(std::unique(checks.begin(), checks.end(), same), checks.end());
+    checks.resize(std::min(checks.size(), endgame_size));
+
+    if (checks.empty()) {
+        return false;
+    }
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    duplicates_mutex_.lock();
+
+    for (auto const& check: checks) {
+        duplicates_.insert(check.hash());
+    }
+
+    duplicates_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (auto const& check: checks) {
+        minimal->insert(hash_digest{ check.hash() }, check.height());
+    }
+
+    LOG_DEBUG(LOG_NODE
+       , "Duplicated ", checks.size(), " blocks from height "
+       , checks.front().height(), " to slot (", minimal->slot(), ").");
+
+    // This may become empty between insert and this test, which is okay.
+    return ! minimal->empty();
+}
+
+// While rows still have work, endgame only starts once the import stalls on
+// the lowest outstanding height, which is then also requested by the fastest
+// active row. Hashes already duplicated may be held by that row, so are
+// skipped.
+void reservations::expedite() {
+    auto const rows = table();
+    reservation::ptr holder;
+    reservation::ptr fastest;
+    auto lowest = max_size_t;
+
+    for (auto const& row: rows) {
+        check_list::checks first;
+        row->lowest(1, first);
+
+        if ( ! first.empty() && first.front().height() < lowest) {
+            lowest = first.front().height();
+            holder = row;
+        }
+    }
+
+    if ( ! holder) {
+        return;
+    }
+
+    for (auto const& row: rows) {
+        if (row == holder || row->idle() || row->retired() || row->stopped()) {
+            continue;
+        }
+
+        if ( ! fastest || fastest->rate().normal() < row->rate().normal()) {
+            fastest = row;
+        }
+    }
+
+    if ( ! fastest) {
+        return;
+    }
+
+    check_list::checks checks;
+    holder->lowest(endgame_size, checks);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    duplicates_mutex_.lock();
+
+    auto const duplicated = [this](auto const& check) {
+        return ! duplicates_.insert(check.hash()).second;
+    };
+
+    checks.erase(std::remove_if(checks.begin(), checks.end(), duplicated), checks.end());
+
+    duplicates_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (checks.empty()) {
+        return;
+    }
+
+    for (auto const& check: checks) {
+        fastest->insert(hash_digest{ check.hash() }, check.height());
+    }
+
+    LOG_DEBUG(LOG_NODE
+       , "Duplicated ", checks.size(), " stalled blocks from height "
+       , checks.front().height(), " of slot (", holder->slot(), ") to slot ("
+       , fastest->slot(), ").");
+}
+
+// Endgame ends as the first copy of each duplicated hash is imported, so
+// other imports do not search the table.
+void reservations::cancel(hash_digest const& hash) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(duplicates_mutex_);
+
+        if (duplicates_.find(hash) == duplicates_.end()) {
+            return;
+        }
+    }
+
+    {
+        unique_lock lock(duplicates_mutex_);
+
+        if (duplicates_.erase(hash) == 0) {
+            return;
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    size_t height;
+
+    for (auto const& row: table()) {
+        row->find_height_and_erase(hash, height);
+    }
 }
 
 // Return false if minimal is empty.
@@ -207,21 +877,28 @@ bool reservations::reserve(reservation::ptr minimal) {
         return true;
     }
 
-    auto const allocation = std::min(hashes_.size(), max_request());
+    if (hashes_.empty()) {
+        return false;
+    }
 
-    size_t height;
-    hash_digest hash;
+    // The count may be estimated from a lower height than is dequeued.
+    auto const count = sizes_.count(hashes_.first(), max_bytes(), max_request());
+
+    check_list::checks checks;
+    hashes_.dequeue_n(checks, count);
 
-    for (size_t block = 0; block < allocation; ++block) {
-        DEBUG_ONLY(auto const result =) hashes_.dequeue(hash, height);
-        KTH_ASSERT_MSG(result, "The checklist is empty.");
-        minimal->insert(std::move(hash), height);
+    for (auto const& check: checks) {
+        minimal->insert(hash_digest{ check.hash() }, check.height());
     }
 
     // This may become empty between insert and this test, which is okay.
     return ! minimal->empty();
 }
 
+uint64_t reservations::max_bytes() const {
+    return maximum_bytes;
+}
+
 // Exposed for test to be able to control the request size.
 size_t reservations::max_request() const {
     return max_request_;
@@ -0,0 +1,175 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/short_id_table.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+namespace kth::node {
+
+// Short ids are 48 bits, so no short id is equal to the empty slot marker.
+static constexpr uint64_t short_id_mask = 0x0000ffffffffffff;
+static constexpr uint64_t empty_slot = ~uint64_t(0);
+
+// Slots per short id, at least, keeping probe sequences short.
+static constexpr size_t load_inverse = 2;
+
+// Short ids are chosen by the peer, so a longer probe sequence is rejected.
+static constexpr size_t maximum_probes = 32;
+
+// The number of 64 bit words in a transaction hash.
+static constexpr size_t hash_words = sizeof(hash_digest) / sizeof(uint64_t);
+
+static uint64_t read_little_endian(uint8_t const* data) {
+    uint64_t value = 0;
+
+    for (size_t byte = 0; byte < sizeof(value); ++byte) {
+        value |= uint64_t(data[byte]) << (8 * byte);
+    }
+
+    return value;
+}
+
+static inline void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+    v0 += v1;
+    v1 = std::rotl(v1, 13) ^ v0;
+    v0 = std::rotl(v0, 32);
+    v2 += v3;
+    v3 = std::rotl(v3, 16) ^ v2;
+    v0 += v3;
+    v3 = std::rotl(v3, 21) ^ v0;
+    v2 += v1;
+    v1 = std::rotl(v1, 17) ^ v2;
+    v2 = std::rotl(v2, 32);
+}
+
+// SipHash-2-4 specialized to a 32 byte message, so there is no tail.
+static inline uint64_t siphash(short_id_table::key const& key, hash_digest const& hash) {
+    auto v0 = 0x736f6d6570736575 ^ key.k0;
+    auto v1 = 0x646f72616e646f6d ^ key.k1;
+    auto v2 = 0x6c7967656e657261 ^ key.k0;
+    auto v3 = 0x7465646279746573 ^ key.k1;
+
+    auto const compress = [&](uint64_t word) {
+        v3 ^= word;
+        sip_round(v0, v1, v2, v3);
+        sip_round(v0, v1, v2, v3);
+        v0 ^= word;
+    };
+
+    for (size_t index = 0; index < hash_words; ++index) {
+        compress(read_little_endian(hash.data() + index * sizeof(uint64_t)));
+    }
+
+    // The final word carries the message length in its high byte.
+    compress(uint64_t(sizeof(hash_digest)) << 56);
+
+    v2 ^= 0xff;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    return (v0 ^ v1 ^ v2 ^ v3) & short_id_mask;
+}
+
+// A process secret, so that the peer cannot choose ids that share a slot.
+static uint64_t slot_seed() {
+    static uint64_t const seed = []() {
+        std::random_device device;
+        return (uint64_t(device()) << 32) | device();
+    }();
+
+    return seed;
+}
+
+short_id_table::key short_id_table::make_key(domain::chain::header const& header, uint64_t nonce) {
+    auto data = header.to_data();
+
+    for (size_t byte = 0; byte < sizeof(nonce); ++byte) {
+        data.push_back(static_cast<uint8_t>(nonce >> (8 * byte)));
+    }
+
+    auto const hash = sha256_hash(data);
+    return { read_little_endian(hash.data()), read_little_endian(hash.data() + sizeof(uint64_t)) };
+}
+
+uint64_t short_id_table::short_id(key const& key, hash_digest const& hash) {
+    return siphash(key, hash);
+}
+
+// The hashes are independent, so their computation overlaps in the pipeline.
+void short_id_table::short_ids(key const& key, hash_digest const* hashes, size_t count, uint64_t* out) {
+    for (size_t index = 0; index < count; ++index) {
+        out[index] = siphash(key, hashes[index]);
+    }
+}
+
+short_id_table::short_id_table(size_t count)
+    : mask_(std::bit_ceil(std::max(count * load_inverse, size_t(8))) - 1)
+    , size_(0)
+    , ids_(mask_ + 1, empty_slot)
+    , indexes_(mask_ + 1)
+{}
+
+size_t short_id_table::size() const {
+    return size_;
+}
+
+bool short_id_table::insert(uint64_t short_id, uint16_t index) {
+    auto position = slot(short_id);
+
+    for (size_t probe = 0; probe < maximum_probes; ++probe) {
+        auto& id = ids_[position];
+
+        if (id == short_id) {
+            return false;
+        }
+
+        if (id == empty_slot) {
+            id = short_id;
+            indexes_[position] = index;
+            ++size_;
+            return true;
+        }
+
+        position = (position + 1) & mask_;
+    }
+
+    return false;
+}
+
+bool short_id_table::find(uint64_t short_id, uint16_t& out_index) const {
+    auto position = slot(short_id);
+
+    for (size_t probe = 0; probe < maximum_probes; ++probe) {
+        auto const id = ids_[position];
+
+        if (id == short_id) {
+            out_index = indexes_[position];
+            return true;
+        }
+
+        if (id == empty_slot) {
+            return false;
+        }
+
+        position = (position + 1) & mask_;
+    }
+
+    return false;
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+size_t short_id_table::slot(uint64_t short_id) const {
+    auto const mixed = (short_id ^ slot_seed()) * 0x9e3779b97f4a7c15;
+    return static_cast<size_t>(mixed >> 32) & mask_;
+}
+
+} // namespace kth::node
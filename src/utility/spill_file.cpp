@@ -0,0 +1,207 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/spill_file.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <system_error>
+
+namespace kth::node {
+
+using namespace boost::interprocess;
+
+// The initial size of the file, grown by doubling.
+static constexpr uint64_t minimum_capacity = 64 * 1024 * 1024;
+
+spill_file::spill_file(std::filesystem::path const& path)
+    : path_(path)
+    , capacity_(0)
+    , end_(0)
+    , size_(0)
+{}
+
+spill_file::~spill_file() {
+    close();
+}
+
+bool spill_file::open() {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (region_) {
+        return false;
+    }
+
+    // Create or truncate the file, which must exist to be mapped.
+    if ( ! std::ofstream(path_, std::ios::binary | std::ios::trunc)) {
+        return false;
+    }
+
+    return map(minimum_capacity);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void spill_file::close() {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if ( ! region_) {
+        return;
+    }
+
+    region_.reset();
+    free_.clear();
+    capacity_ = 0;
+    end_ = 0;
+    size_ = 0;
+
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+uint64_t spill_file::size() const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return size_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool spill_file::store(data_chunk const& data, uint64_t& out_offset) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if ( ! region_ || ! allocate(data.size(), out_offset)) {
+        return false;
+    }
+
+    auto const buffer = static_cast<uint8_t*>(region_->get_address());
+    std::memcpy(buffer + out_offset, data.data(), data.size());
+    size_ += data.size();
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void spill_file::release(uint64_t offset, uint64_t size) {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if ( ! region_ || size == 0) {
+        return;
+    }
+
+    KTH_ASSERT(size_ >= size);
+    size_ -= size;
+
+    // Nothing remains stored, so the file is reused from its start.
+    if (size_ == 0) {
+        free_.clear();
+        end_ = 0;
+        return;
+    }
+
+    auto it = free_.emplace(offset, size).first;
+
+    // Coalesce with the following free range.
+    auto const next = std::next(it);
+
+    if (next != free_.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        free_.erase(next);
+    }
+
+    // Coalesce with the preceding free range.
+    if (it != free_.begin()) {
+        auto const previous = std::prev(it);
+
+        if (previous->first + previous->second == it->first) {
+            previous->second += it->second;
+            free_.erase(it);
+            it = previous;
+        }
+    }
+
+    // A free range at the end of use is returned to the end.
+    if (it->first + it->second == end_) {
+        end_ = it->first;
+        free_.erase(it);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+bool spill_file::map(uint64_t capacity) {
+    // The region is released before the file is resized and mapped again.
+    region_.reset();
+
+    std::error_code ec;
+    std::filesystem::resize_file(path_, capacity, ec);
+
+    if (ec) {
+        return false;
+    }
+
+    try {
+        file_mapping const mapping(path_.string().c_str(), read_write);
+        region_ = std::make_unique<mapped_region>(mapping, read_write);
+    } catch (interprocess_exception const&) {
+        return false;
+    }
+
+    capacity_ = capacity;
+    return true;
+}
+
+// First fit, as ranges are released largely in the order they are stored.
+bool spill_file::allocate(uint64_t size, uint64_t& out_offset) {
+    auto const fits = [size](auto const& range) {
+        return range.second >= size;
+    };
+
+    auto const it = std::find_if(free_.begin(), free_.end(), fits);
+
+    if (it != free_.end()) {
+        out_offset = it->first;
+
+        if (it->second > size) {
+            free_.emplace(it->first + size, it->second - size);
+        }
+
+        free_.erase(it);
+        return true;
+    }
+
+    if (end_ + size > capacity_) {
+        auto capacity = std::max(capacity_, minimum_capacity);
+
+        while (capacity < end_ + size) {
+            capacity *= 2;
+        }
+
+        // On failure the stored ranges are mapped again at the old size.
+        if ( ! map(capacity)) {
+            map(capacity_);
+            return false;
+        }
+    }
+
+    out_offset = end_;
+    end_ += size;
+    return true;
+}
+
+} // namespace kth::node
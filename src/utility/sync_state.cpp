@@ -0,0 +1,169 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/sync_state.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+namespace kth::node {
+
+using namespace kth::domain::chain;
+
+// Identifies the file format, "kthsync" and a version byte.
+static constexpr uint64_t magic = 0x02636e797368746b;
+
+// The offset of the import height, following the magic and first height.
+static constexpr size_t import_offset = 2 * sizeof(uint64_t);
+
+// The size of the magic, first height and import height preceding headers.
+static constexpr size_t prefix_size = 3 * sizeof(uint64_t);
+
+// The size of a serialized header.
+static constexpr size_t header_size = 80;
+
+static void write_little_endian(uint8_t* out, uint64_t value) {
+    for (size_t byte = 0; byte < sizeof(value); ++byte) {
+        out[byte] = static_cast<uint8_t>(value >> (8 * byte));
+    }
+}
+
+static uint64_t read_little_endian(uint8_t const* data) {
+    uint64_t value = 0;
+
+    for (size_t byte = 0; byte < sizeof(value); ++byte) {
+        value |= uint64_t(data[byte]) << (8 * byte);
+    }
+
+    return value;
+}
+
+sync_state::sync_state(std::filesystem::path const& path)
+    : path_(path)
+    , open_(false)
+    , next_(0)
+    , import_(0)
+{}
+
+bool sync_state::open(size_t& out_first_height, header::list& out_headers) {
+    open_ = false;
+    std::ifstream file(path_, std::ios::binary);
+    uint8_t prefix[prefix_size];
+
+    if ( ! file.read(reinterpret_cast<char*>(prefix), prefix_size) ||
+        read_little_endian(prefix) != magic) {
+        return false;
+    }
+
+    auto const first = static_cast<size_t>(read_little_endian(prefix + sizeof(uint64_t)));
+    auto const import = static_cast<size_t>(read_little_endian(prefix + import_offset));
+    data_chunk data(header_size);
+    header::list headers;
+
+    while (file.read(reinterpret_cast<char*>(data.data()), header_size)) {
+        auto header = header::factory_from_data(data);
+
+        // The file may have been partially written when the node stopped.
+        if ( ! header.is_valid() || ( ! headers.empty() &&
+            header.previous_block_hash() != headers.back().hash())) {
+            break;
+        }
+
+        headers.push_back(std::move(header));
+    }
+
+    file.close();
+
+    // Appends continue from the last linked header.
+    std::error_code ec;
+    std::filesystem::resize_file(path_, prefix_size + headers.size() * header_size, ec);
+
+    if (ec) {
+        return false;
+    }
+
+    open_ = true;
+    next_ = first + headers.size();
+    import_ = import;
+    out_first_height = first;
+    out_headers = std::move(headers);
+    return true;
+}
+
+bool sync_state::create(size_t first_height) {
+    open_ = false;
+    std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+    uint8_t prefix[prefix_size];
+    write_little_endian(prefix, magic);
+    write_little_endian(prefix + sizeof(uint64_t), first_height);
+    write_little_endian(prefix + import_offset, first_height);
+
+    if ( ! file.write(reinterpret_cast<char const*>(prefix), prefix_size)) {
+        return false;
+    }
+
+    open_ = true;
+    next_ = first_height;
+    import_ = first_height;
+    return true;
+}
+
+bool sync_state::append(header::list const& headers, size_t first_height) {
+    if ( ! open_ || first_height != next_) {
+        return false;
+    }
+
+    std::ofstream file(path_, std::ios::binary | std::ios::app);
+
+    for (auto const& header: headers) {
+        auto const data = header.to_data();
+
+        // The file is abandoned, as it can no longer be extended in order.
+        if ( ! file.write(reinterpret_cast<char const*>(data.data()), data.size())) {
+            open_ = false;
+            return false;
+        }
+    }
+
+    next_ += headers.size();
+    return true;
+}
+
+size_t sync_state::next_height() const {
+    return next_;
+}
+
+size_t sync_state::import_height() const {
+    return import_;
+}
+
+// The height is overwritten in place, the headers are unchanged.
+bool sync_state::set_import_height(size_t height) {
+    if ( ! open_) {
+        return false;
+    }
+
+    std::fstream file(path_, std::ios::binary | std::ios::in | std::ios::out);
+    uint8_t data[sizeof(uint64_t)];
+    write_little_endian(data, height);
+
+    if ( ! file.seekp(import_offset) ||
+        ! file.write(reinterpret_cast<char const*>(data), sizeof(data))) {
+        return false;
+    }
+
+    import_ = height;
+    return true;
+}
+
+void sync_state::remove() {
+    open_ = false;
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+} // namespace kth::node
@@ -0,0 +1,83 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kth/node/utility/transaction_ring.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace kth::node {
+
+transaction_ring::transaction_ring(size_t capacity)
+    : capacity_(capacity)
+    , next_(0)
+{
+    ring_.reserve(capacity);
+}
+
+size_t transaction_ring::size() const {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return ring_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_ring::store(transaction_const_ptr transaction) {
+    if (capacity_ == 0) {
+        return;
+    }
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (ring_.size() < capacity_) {
+        ring_.push_back(std::move(transaction));
+        return;
+    }
+
+    ring_[next_] = std::move(transaction);
+    next_ = (next_ + 1) % capacity_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t transaction_ring::fill(short_id_table::key const& key, short_id_table const& table, std::vector<domain::chain::transaction>& out) const {
+    std::vector<transaction_const_ptr> transactions;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(mutex_);
+        transactions = ring_;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    hash_list hashes;
+    hashes.reserve(transactions.size());
+
+    for (auto const& transaction: transactions) {
+        hashes.push_back(transaction->hash());
+    }
+
+    std::vector<uint64_t> ids(hashes.size());
+    short_id_table::short_ids(key, hashes.data(), hashes.size(), ids.data());
+    size_t filled = 0;
+
+    for (size_t position = 0; position < ids.size(); ++position) {
+        uint16_t index;
+
+        if (table.find(ids[position], index) && index < out.size() &&
+            ! out[index].is_valid()) {
+            out[index] = *transactions[position];
+            ++filled;
+        }
+    }
+
+    return filled;
+}
+
+} // namespace kth::node
@@ -0,0 +1,76 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+
+// Start Test Suite: announcement ranking tests
+
+static
+hash_digest make_hash(uint8_t value) {
+    return hash_digest{ { value } };
+}
+
+TEST_CASE("announcement_ranking  is_top  unannounced  false", "[announcement ranking tests]") {
+    announcement_ranking instance(3, 10);
+    REQUIRE( ! instance.is_top(1));
+}
+
+TEST_CASE("announcement_ranking  announce  later announcer  not credited", "[announcement ranking tests]") {
+    announcement_ranking instance(1, 10);
+    instance.announce(make_hash(1), 1);
+    instance.announce(make_hash(1), 2);
+    REQUIRE(instance.is_top(1));
+    REQUIRE( ! instance.is_top(2));
+}
+
+TEST_CASE("announcement_ranking  is_top  more credits  ranked above", "[announcement ranking tests]") {
+    announcement_ranking instance(2, 10);
+    instance.announce(make_hash(1), 1);
+    instance.announce(make_hash(2), 1);
+    instance.announce(make_hash(3), 2);
+    instance.announce(make_hash(4), 2);
+    instance.announce(make_hash(5), 2);
+    instance.announce(make_hash(6), 3);
+    REQUIRE(instance.is_top(1));
+    REQUIRE(instance.is_top(2));
+    REQUIRE( ! instance.is_top(3));
+}
+
+TEST_CASE("announcement_ranking  is_top  tie  most recent ranked above", "[announcement ranking tests]") {
+    announcement_ranking instance(1, 10);
+    instance.announce(make_hash(1), 1);
+    instance.announce(make_hash(2), 2);
+    REQUIRE( ! instance.is_top(1));
+    REQUIRE(instance.is_top(2));
+}
+
+TEST_CASE("announcement_ranking  announce  beyond window  rotated", "[announcement ranking tests]") {
+    announcement_ranking instance(1, 2);
+    instance.announce(make_hash(1), 1);
+    instance.announce(make_hash(2), 1);
+    REQUIRE(instance.is_top(1));
+
+    instance.announce(make_hash(3), 2);
+    instance.announce(make_hash(4), 2);
+    REQUIRE( ! instance.is_top(1));
+    REQUIRE(instance.is_top(2));
+}
+
+TEST_CASE("announcement_ranking  remove  top  next promoted", "[announcement ranking tests]") {
+    announcement_ranking instance(1, 10);
+    instance.announce(make_hash(1), 1);
+    instance.announce(make_hash(2), 1);
+    instance.announce(make_hash(3), 2);
+    REQUIRE( ! instance.is_top(2));
+
+    instance.remove(1);
+    REQUIRE( ! instance.is_top(1));
+    REQUIRE(instance.is_top(2));
+}
+
+// End Test Suite
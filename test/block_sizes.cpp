@@ -0,0 +1,47 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+
+// Start Test Suite: block sizes tests
+
+TEST_CASE("block_sizes  estimate  default  default size", "[block sizes tests]") {
+    block_sizes instance(42);
+    REQUIRE(instance.estimate(0) == 42u);
+    REQUIRE(instance.estimate(500000) == 42u);
+}
+
+TEST_CASE("block_sizes  estimate  recorded interval  average", "[block sizes tests]") {
+    block_sizes instance(42);
+    instance.record(10, 100);
+    instance.record(20, 300);
+    REQUIRE(instance.estimate(0) == 200u);
+    REQUIRE(instance.estimate(block_sizes::interval - 1) == 200u);
+}
+
+TEST_CASE("block_sizes  estimate  unrecorded interval  latest average", "[block sizes tests]") {
+    block_sizes instance(42);
+    instance.record(10, 100);
+    instance.record(5 * block_sizes::interval, 1000);
+    REQUIRE(instance.estimate(2 * block_sizes::interval) == 1000u);
+    REQUIRE(instance.estimate(9 * block_sizes::interval) == 1000u);
+    REQUIRE(instance.estimate(10) == 100u);
+}
+
+TEST_CASE("block_sizes  count  budget  blocks within bytes", "[block sizes tests]") {
+    block_sizes instance(100);
+    REQUIRE(instance.count(0, 1000, 50) == 10u);
+    REQUIRE(instance.count(0, 1000, 5) == 5u);
+}
+
+TEST_CASE("block_sizes  count  budget below one block  one", "[block sizes tests]") {
+    block_sizes instance(100);
+    REQUIRE(instance.count(0, 10, 50) == 1u);
+}
+
+// End Test Suite
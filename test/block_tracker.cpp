@@ -0,0 +1,157 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chrono>
+#include <vector>
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+
+// Start Test Suite: block tracker tests
+
+class block_tracker_fixture : public block_tracker {
+public:
+    block_tracker_fixture()
+        : block_tracker(std::chrono::seconds(10))
+        , now_(clock::now())
+    {}
+
+    void advance(clock::duration elapsed) {
+        now_ += elapsed;
+    }
+
+protected:
+    clock::time_point now() const override {
+        return now_;
+    }
+
+private:
+    clock::time_point now_;
+};
+
+static
+hash_digest const hash1{ { 1 } };
+
+static
+hash_digest const hash2{ { 2 } };
+
+TEST_CASE("block_tracker  request  untracked  true", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    REQUIRE(instance.request(hash1, 1, nullptr));
+    REQUIRE(instance.request(hash2, 1, nullptr));
+    REQUIRE(instance.size() == 2u);
+}
+
+TEST_CASE("block_tracker  request  tracked  false", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    REQUIRE(instance.request(hash1, 1, nullptr));
+    REQUIRE( ! instance.request(hash1, 1, nullptr));
+    REQUIRE( ! instance.request(hash1, 2, nullptr));
+    REQUIRE(instance.size() == 1u);
+}
+
+TEST_CASE("block_tracker  request  stalled  true", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    REQUIRE(instance.request(hash1, 1, nullptr));
+    instance.advance(std::chrono::seconds(10));
+    REQUIRE(instance.request(hash1, 2, nullptr));
+    REQUIRE( ! instance.request(hash1, 1, nullptr));
+}
+
+TEST_CASE("block_tracker  request  race  true up to race", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    REQUIRE(instance.request(hash1, 1, nullptr, 2));
+    REQUIRE(instance.request(hash1, 2, nullptr, 2));
+    REQUIRE( ! instance.request(hash1, 2, nullptr, 2));
+    REQUIRE( ! instance.request(hash1, 3, nullptr, 2));
+    REQUIRE(instance.size() == 1u);
+}
+
+TEST_CASE("block_tracker  release  one of race  fallback not invoked", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    auto invoked = false;
+
+    auto const fallback = [&invoked](hash_digest const&) {
+        invoked = true;
+    };
+
+    REQUIRE(instance.request(hash1, 1, nullptr, 2));
+    REQUIRE(instance.request(hash1, 2, nullptr, 2));
+    REQUIRE( ! instance.request(hash1, 3, fallback, 2));
+    instance.release(1);
+    REQUIRE( ! invoked);
+
+    instance.release(2);
+    REQUIRE(invoked);
+}
+
+TEST_CASE("block_tracker  complete  tracked  requestable", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    REQUIRE(instance.request(hash1, 1, nullptr));
+    instance.complete(hash1);
+    REQUIRE(instance.size() == 0u);
+    REQUIRE(instance.request(hash1, 2, nullptr));
+}
+
+TEST_CASE("block_tracker  release  waiting  fallback invoked", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    std::vector<hash_digest> fallen;
+
+    auto const fallback = [&fallen](hash_digest const& hash) {
+        fallen.push_back(hash);
+    };
+
+    REQUIRE(instance.request(hash1, 1, nullptr));
+    REQUIRE(instance.request(hash2, 1, nullptr));
+    REQUIRE( ! instance.request(hash1, 2, fallback));
+    instance.release(1);
+
+    // The waited block passes to the waiting channel, the other is dropped.
+    REQUIRE(fallen.size() == 1u);
+    REQUIRE(fallen.front() == hash1);
+    REQUIRE(instance.size() == 1u);
+    REQUIRE( ! instance.request(hash1, 2, nullptr));
+}
+
+TEST_CASE("block_tracker  release  waiter  not invoked", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    auto invoked = false;
+
+    auto const fallback = [&invoked](hash_digest const&) {
+        invoked = true;
+    };
+
+    REQUIRE(instance.request(hash1, 1, nullptr));
+    REQUIRE( ! instance.request(hash1, 2, fallback));
+    instance.release(2);
+    instance.release(1);
+    REQUIRE( ! invoked);
+    REQUIRE(instance.size() == 0u);
+}
+
+TEST_CASE("block_tracker  expire  stalled  fallback invoked once", "[block tracker tests]") {
+    block_tracker_fixture instance;
+    size_t invoked = 0;
+
+    auto const fallback = [&invoked](hash_digest const&) {
+        ++invoked;
+    };
+
+    REQUIRE(instance.request(hash1, 1, nullptr));
+    REQUIRE( ! instance.request(hash1, 2, fallback));
+    instance.expire();
+    REQUIRE(invoked == 0u);
+
+    instance.advance(std::chrono::seconds(10));
+    instance.expire();
+    REQUIRE(invoked == 1u);
+
+    // The request was renewed by the waiting channel.
+    instance.expire();
+    REQUIRE(invoked == 1u);
+}
+
+// End Test Suite
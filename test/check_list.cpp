@@ -6,11 +6,132 @@
 #include <kth/node.hpp>
 
 using namespace kth;
+using namespace kth::node;
+using namespace kth::node::test;
 
 // Start Test Suite: check list tests
 
-TEST_CASE("check_list TODO", "[check list tests]") {
-    REQUIRE(true);
+TEST_CASE("check_list  default  empty", "[check list tests]") {
+    check_list instance;
+    REQUIRE(instance.empty());
+    REQUIRE(instance.size() == 0u);
+}
+
+TEST_CASE("check_list  reserve  42 to 51  size 10", "[check list tests]") {
+    check_list instance;
+    REQUIRE(instance.reserve(42, 51));
+    REQUIRE( ! instance.empty());
+    REQUIRE(instance.size() == 10u);
+}
+
+TEST_CASE("check_list  reserve  contiguous  extends", "[check list tests]") {
+    check_list instance;
+    REQUIRE(instance.reserve(42, 51));
+    REQUIRE(instance.reserve(52, 61));
+    REQUIRE(instance.size() == 20u);
+}
+
+TEST_CASE("check_list  reserve  gap  false", "[check list tests]") {
+    check_list instance;
+    REQUIRE(instance.reserve(42, 51));
+    REQUIRE( ! instance.reserve(53, 61));
+    REQUIRE(instance.size() == 10u);
+}
+
+TEST_CASE("check_list  dequeue  empty  false", "[check list tests]") {
+    check_list instance;
+    size_t height;
+    hash_digest hash;
+    REQUIRE( ! instance.dequeue(hash, height));
+}
+
+TEST_CASE("check_list  enqueue  unreserved  ignored", "[check list tests]") {
+    check_list instance;
+    instance.reserve(42, 42);
+    instance.enqueue(make_hash(41), 41);
+    instance.enqueue(make_hash(43), 43);
+
+    size_t height;
+    hash_digest hash;
+    REQUIRE(instance.dequeue(hash, height));
+    REQUIRE(height == 42u);
+    REQUIRE(hash == null_hash);
+    REQUIRE(instance.empty());
+}
+
+TEST_CASE("check_list  dequeue  enqueued  height order", "[check list tests]") {
+    check_list instance;
+    instance.reserve(42, 44);
+    instance.enqueue(make_hash(44), 44);
+    instance.enqueue(make_hash(42), 42);
+    instance.enqueue(make_hash(43), 43);
+
+    size_t height;
+    hash_digest hash;
+
+    for (size_t expected = 42; expected <= 44; ++expected) {
+        REQUIRE(instance.dequeue(hash, height));
+        REQUIRE(height == expected);
+        REQUIRE(hash == make_hash(expected));
+    }
+
+    REQUIRE(instance.empty());
+}
+
+TEST_CASE("check_list  dequeue n  across chunks  height order", "[check list tests]") {
+    auto const first = check_list::chunk_size - 10;
+    auto const count = 3 * check_list::chunk_size;
+
+    hash_list hashes;
+    for (size_t index = 0; index < count; ++index) {
+        hashes.push_back(make_hash(first + index));
+    }
+
+    check_list instance;
+    instance.reserve(first, first + count - 1);
+    instance.enqueue(hashes, first);
+
+    check_list::checks checks;
+    REQUIRE(instance.dequeue_n(checks, 20) == 20u);
+    REQUIRE(instance.dequeue_n(checks, count) == count - 20);
+    REQUIRE(instance.dequeue_n(checks, count) == 0u);
+    REQUIRE(instance.empty());
+    REQUIRE(checks.size() == count);
+
+    for (size_t index = 0; index < count; ++index) {
+        REQUIRE(checks[index].height() == first + index);
+        REQUIRE(checks[index].hash() == make_hash(first + index));
+    }
+}
+
+TEST_CASE("check_list  reserve  after drained  restarts", "[check list tests]") {
+    check_list instance;
+    instance.reserve(42, 43);
+
+    check_list::checks checks;
+    instance.dequeue_n(checks, 2);
+    REQUIRE(instance.empty());
+
+    REQUIRE(instance.reserve(100000, 100000));
+    instance.enqueue(make_hash(7), 100000);
+
+    size_t height;
+    hash_digest hash;
+    REQUIRE(instance.dequeue(hash, height));
+    REQUIRE(height == 100000u);
+    REQUIRE(hash == make_hash(7));
+}
+
+
+TEST_CASE("check_list  first  dequeued  next height", "[check list tests]") {
+    check_list instance;
+    REQUIRE(instance.reserve(42, 51));
+    REQUIRE(instance.first() == 42u);
+
+    hash_digest hash;
+    size_t height;
+    REQUIRE(instance.dequeue(hash, height));
+    REQUIRE(instance.first() == 43u);
 }
 
 // End Test Suite
@@ -0,0 +1,195 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+using namespace kth::node::test;
+
+// Start Test Suite: hash heights tests
+
+TEST_CASE("hash_heights  default  empty", "[hash heights tests]") {
+    hash_heights instance;
+    REQUIRE(instance.empty());
+    REQUIRE(instance.size() == 0u);
+}
+
+TEST_CASE("hash_heights  find_and_erase  empty  false", "[hash heights tests]") {
+    hash_heights instance;
+    size_t height = 42;
+    REQUIRE( ! instance.find_and_erase(make_hash(1), height));
+    REQUIRE(height == 42u);
+}
+
+TEST_CASE("hash_heights  find_and_erase  inserted  true with height", "[hash heights tests]") {
+    hash_heights instance;
+    instance.insert(make_hash(1), 10);
+    instance.insert(make_hash(2), 11);
+    REQUIRE(instance.size() == 2u);
+
+    size_t height;
+    REQUIRE(instance.find_and_erase(make_hash(2), height));
+    REQUIRE(height == 11u);
+    REQUIRE(instance.size() == 1u);
+    REQUIRE( ! instance.find_and_erase(make_hash(2), height));
+    REQUIRE(instance.find_and_erase(make_hash(1), height));
+    REQUIRE(height == 10u);
+    REQUIRE(instance.empty());
+}
+
+TEST_CASE("hash_heights  for_each  unordered insert  increasing height", "[hash heights tests]") {
+    hash_heights instance;
+    instance.insert(make_hash(3), 13);
+    instance.insert(make_hash(1), 11);
+    instance.insert(make_hash(2), 12);
+
+    std::vector<size_t> heights;
+    instance.for_each([&](hash_digest const& hash, size_t height) {
+        REQUIRE(hash == make_hash(height - 10));
+        heights.push_back(height);
+    });
+
+    REQUIRE(heights == std::vector<size_t>{ 11, 12, 13 });
+
+    size_t height;
+    REQUIRE(instance.find_and_erase(make_hash(1), height));
+    REQUIRE(height == 11u);
+}
+
+TEST_CASE("hash_heights  move_back  half  moves highest", "[hash heights tests]") {
+    hash_heights instance;
+    hash_heights minimal;
+
+    for (size_t index = 0; index < 5; ++index) {
+        instance.insert(make_hash(index), index);
+    }
+
+    REQUIRE(instance.move_back(minimal, 2) == 2u);
+    REQUIRE(instance.size() == 3u);
+    REQUIRE(minimal.size() == 2u);
+
+    size_t height;
+    REQUIRE( ! instance.find_and_erase(make_hash(4), height));
+    REQUIRE(minimal.find_and_erase(make_hash(3), height));
+    REQUIRE(height == 3u);
+    REQUIRE(instance.find_and_erase(make_hash(2), height));
+    REQUIRE(height == 2u);
+
+    // The remaining range continues to accept higher entries.
+    instance.insert(make_hash(5), 5);
+    REQUIRE(instance.find_and_erase(make_hash(5), height));
+    REQUIRE(height == 5u);
+}
+
+TEST_CASE("hash_heights  move_back  erased entries  skipped", "[hash heights tests]") {
+    hash_heights instance;
+    hash_heights minimal;
+
+    for (size_t index = 0; index < 6; ++index) {
+        instance.insert(make_hash(index), index);
+    }
+
+    size_t height;
+    REQUIRE(instance.find_and_erase(make_hash(4), height));
+    REQUIRE(instance.move_back(minimal, 2) == 2u);
+    REQUIRE(instance.size() == 3u);
+
+    std::vector<size_t> heights;
+    minimal.for_each([&](hash_digest const&, size_t value) {
+        heights.push_back(value);
+    });
+
+    REQUIRE(heights == std::vector<size_t>{ 3, 5 });
+}
+
+TEST_CASE("hash_heights  find_and_erase  many  all found", "[hash heights tests]") {
+    static size_t const count = 50000;
+    hash_heights instance;
+
+    for (size_t index = 0; index < count; ++index) {
+        instance.insert(make_hash(index), index);
+    }
+
+    REQUIRE(instance.size() == count);
+
+    // Erase out of order to exercise tombstones and compaction.
+    size_t height;
+    for (size_t index = 1; index < count; index += 2) {
+        REQUIRE(instance.find_and_erase(make_hash(index), height));
+        REQUIRE(height == index);
+    }
+
+    for (size_t index = 0; index < count; index += 2) {
+        REQUIRE(instance.find_and_erase(make_hash(index), height));
+        REQUIRE(height == index);
+    }
+
+    REQUIRE(instance.empty());
+}
+
+TEST_CASE("hash_heights  request  count  lowest unrequested", "[hash heights tests]") {
+    hash_heights instance;
+
+    for (size_t index = 0; index < 5; ++index) {
+        instance.insert(make_hash(index), index);
+    }
+
+    std::vector<size_t> heights;
+    auto const handler = [&](hash_digest const&, size_t height) {
+        heights.push_back(height);
+    };
+
+    REQUIRE(instance.request(2, handler) == 2u);
+    REQUIRE(instance.requested() == 2u);
+    REQUIRE(instance.request(2, handler) == 2u);
+    REQUIRE(instance.request(2, handler) == 1u);
+    REQUIRE(heights == std::vector<size_t>{ 0, 1, 2, 3, 4 });
+    REQUIRE(instance.requested() == 5u);
+
+    size_t height;
+    REQUIRE(instance.find_and_erase(make_hash(1), height));
+    REQUIRE(instance.requested() == 4u);
+
+    instance.reset_requested();
+    REQUIRE(instance.requested() == 0u);
+    REQUIRE(instance.request(10, handler) == 4u);
+}
+
+TEST_CASE("hash_heights  move_back  requested  moved unrequested", "[hash heights tests]") {
+    hash_heights instance;
+    hash_heights minimal;
+
+    for (size_t index = 0; index < 4; ++index) {
+        instance.insert(make_hash(index), index);
+    }
+
+    auto const handler = [](hash_digest const&, size_t) {};
+    REQUIRE(instance.request(3, handler) == 3u);
+    REQUIRE(instance.move_back(minimal, 2) == 2u);
+    REQUIRE(instance.requested() == 2u);
+    REQUIRE(minimal.requested() == 0u);
+    REQUIRE(minimal.request(10, handler) == 2u);
+}
+
+TEST_CASE("hash_heights  front  count  lowest entries", "[hash heights tests]") {
+    hash_heights instance;
+
+    for (size_t index = 0; index < 5; ++index) {
+        instance.insert(make_hash(index), index);
+    }
+
+    size_t height;
+    REQUIRE(instance.find_and_erase(make_hash(1), height));
+
+    std::vector<size_t> heights;
+    instance.front(3, [&](hash_digest const&, size_t value) {
+        heights.push_back(value);
+    });
+
+    REQUIRE(heights == std::vector<size_t>{ 0, 2, 3 });
+}
+
+// End Test Suite
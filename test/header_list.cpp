@@ -4,13 +4,56 @@
 
 #include <test_helpers.hpp>
 #include <kth/node.hpp>
+#include "utility.hpp"
 
 using namespace kth;
+using namespace kth::node;
+using namespace kth::node::test;
 
 // Start Test Suite: header list tests
 
-TEST_CASE("header_list TODO", "[header list tests]") {
-    REQUIRE(true);
+TEST_CASE("header_list  checkpointed  not tail  incomplete", "[header list tests]") {
+    header_list instance(0, check0, check42);
+    REQUIRE( ! instance.tail());
+    REQUIRE( ! instance.complete());
+    REQUIRE(instance.stop_hash() == check42.hash());
+}
+
+TEST_CASE("header_list  tail  target unset  incomplete", "[header list tests]") {
+    header_list instance(3, check42);
+    REQUIRE(instance.tail());
+    REQUIRE( ! instance.complete());
+    REQUIRE(instance.slot() == 3u);
+    REQUIRE(instance.first_height() == 43u);
+    REQUIRE(instance.previous_height() == 42u);
+    REQUIRE(instance.previous_hash() == check42.hash());
+    REQUIRE(instance.stop_hash() == null_hash);
+}
+
+TEST_CASE("header_list  tail  target at start  complete", "[header list tests]") {
+    header_list instance(0, check42);
+    instance.set_target(42);
+    REQUIRE(instance.complete());
+    REQUIRE(instance.headers().empty());
+}
+
+TEST_CASE("header_list  tail  target below start  complete", "[header list tests]") {
+    header_list instance(0, check42);
+    instance.set_target(7);
+    REQUIRE(instance.complete());
+}
+
+TEST_CASE("header_list  tail  target above start  incomplete", "[header list tests]") {
+    header_list instance(0, check42);
+    instance.set_target(43);
+    REQUIRE( ! instance.complete());
+}
+
+TEST_CASE("header_list  tail  merge unlinked  false", "[header list tests]") {
+    header_list instance(0, check42);
+    instance.set_target(100);
+    REQUIRE( ! instance.merge(message_factory(1, make_hash(1))));
+    REQUIRE(instance.previous_height() == 42u);
 }
 
 // End Test Suite
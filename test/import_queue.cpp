@@ -0,0 +1,384 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+
+// Start Test Suite: import queue tests
+
+static
+block_const_ptr make_block() {
+    return std::make_shared<domain::message::block const>();
+}
+
+TEST_CASE("import_queue  default  empty stopped", "[import queue tests]") {
+    import_queue instance(2);
+    REQUIRE(instance.empty());
+    REQUIRE(instance.size() == 0u);
+    REQUIRE( ! instance.full());
+    REQUIRE( ! instance.push(make_block(), 42, nullptr));
+}
+
+TEST_CASE("import_queue  start  twice  false", "[import queue tests]") {
+    import_queue instance(2);
+    REQUIRE(instance.start(42));
+    REQUIRE( ! instance.start(42));
+}
+
+TEST_CASE("import_queue  push  capacity  full", "[import queue tests]") {
+    import_queue instance(2);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE( ! instance.full());
+    REQUIRE(instance.push(make_block(), 43, nullptr));
+    REQUIRE(instance.full());
+
+    // Blocks above capacity are accepted, requests are deferred by caller.
+    REQUIRE(instance.push(make_block(), 44, nullptr));
+    REQUIRE(instance.size() == 3u);
+}
+
+TEST_CASE("import_queue  push  duplicate height  false", "[import queue tests]") {
+    import_queue instance(2);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE( ! instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.size() == 1u);
+}
+
+TEST_CASE("import_queue  push  below cursor  false", "[import queue tests]") {
+    import_queue instance(10);
+    REQUIRE(instance.start(42));
+    REQUIRE( ! instance.push(make_block(), 41, nullptr));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.size() == 1u);
+}
+
+TEST_CASE("import_queue  pop  unordered push  increasing height", "[import queue tests]") {
+    import_queue instance(10);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 47, nullptr));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.push(make_block(), 45, nullptr));
+
+    std::vector<size_t> heights;
+    std::atomic<size_t> popped{ 0 };
+    std::thread importer([&]() {
+        import_queue::entry entry;
+        while (instance.pop(entry)) {
+            heights.push_back(entry.height);
+            instance.imported(entry.height);
+            ++popped;
+        }
+    });
+
+    // The block at 45 is held back until 43 and 44 are queued.
+    while (popped == 0) {
+        std::this_thread::yield();
+    }
+
+    REQUIRE(instance.push(make_block(), 44, nullptr));
+    REQUIRE(instance.push(make_block(), 43, nullptr));
+    instance.stop();
+    importer.join();
+
+    REQUIRE(heights == std::vector<size_t>{ 42, 43, 44, 45 });
+
+    // The block at 47 remains as 46 is missing.
+    REQUIRE(instance.size() == 1u);
+}
+
+TEST_CASE("import_queue  pop  stopped missing cursor  false", "[import queue tests]") {
+    import_queue instance(10);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 43, nullptr));
+    instance.stop();
+
+    import_queue::entry entry;
+    REQUIRE( ! instance.pop(entry));
+    REQUIRE(instance.size() == 1u);
+}
+
+TEST_CASE("import_queue  stop  queued  drained then false", "[import queue tests]") {
+    import_queue instance(10);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    instance.stop();
+    REQUIRE( ! instance.push(make_block(), 43, nullptr));
+
+    import_queue::entry entry;
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 42u);
+    REQUIRE( ! instance.pop(entry));
+}
+
+TEST_CASE("import_queue  pop  waiting  released by push", "[import queue tests]") {
+    import_queue instance(10);
+    REQUIRE(instance.start(42));
+
+    size_t height = 0;
+    std::thread consumer([&]() {
+        import_queue::entry entry;
+        while (instance.pop(entry)) {
+            height = entry.height;
+            instance.imported(entry.height);
+        }
+    });
+
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    instance.stop();
+    consumer.join();
+    REQUIRE(height == 42u);
+}
+
+TEST_CASE("import_queue  prefetch  lowest count  marked once", "[import queue tests]") {
+    import_queue instance(10);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 44, nullptr));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.push(make_block(), 43, nullptr));
+
+    import_queue::list blocks;
+    REQUIRE(instance.prefetch(blocks, 2));
+    REQUIRE(blocks.size() == 2u);
+    REQUIRE(blocks.front().height == 42u);
+    REQUIRE(blocks.back().height == 43u);
+    REQUIRE(instance.size() == 3u);
+
+    // Importing the lowest block brings the next into the window.
+    import_queue::entry entry;
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.prefetched);
+
+    blocks.clear();
+    REQUIRE(instance.prefetch(blocks, 2));
+    REQUIRE(blocks.size() == 1u);
+    REQUIRE(blocks.front().height == 44u);
+}
+
+TEST_CASE("import_queue  prefetch  stopped  false", "[import queue tests]") {
+    import_queue instance(10);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    instance.stop();
+
+    import_queue::list blocks;
+    REQUIRE( ! instance.prefetch(blocks, 2));
+}
+
+TEST_CASE("import_queue  check  lowest unchecked  marked once", "[import queue tests]") {
+    import_queue instance(10, true);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 43, nullptr));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+
+    import_queue::entry first;
+    import_queue::entry second;
+    REQUIRE(instance.check(first));
+    REQUIRE(instance.check(second));
+    REQUIRE(first.height == 42u);
+    REQUIRE(second.height == 43u);
+    REQUIRE(instance.size() == 2u);
+}
+
+TEST_CASE("import_queue  pop  unchecked above  popped in order", "[import queue tests]") {
+    import_queue instance(10, true);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.push(make_block(), 43, nullptr));
+    REQUIRE(instance.push(make_block(), 44, nullptr));
+    instance.checked(42, true);
+    instance.checked(44, true);
+
+    import_queue::entry entry;
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 42u);
+    instance.imported(42);
+
+    // The checked block at 44 waits for the check of 43.
+    instance.checked(43, true);
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 43u);
+    instance.imported(43);
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 44u);
+}
+
+TEST_CASE("import_queue  checked  invalid  cursor held until replaced", "[import queue tests]") {
+    import_queue instance(10, true);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.push(make_block(), 43, nullptr));
+    instance.checked(42, false);
+    instance.checked(43, true);
+    REQUIRE(instance.size() == 1u);
+
+    // The replacement is checked and imported ahead of the block above.
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    instance.checked(42, true);
+
+    import_queue::entry entry;
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 42u);
+    instance.imported(42);
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 43u);
+    REQUIRE(instance.empty());
+}
+
+TEST_CASE("import_queue  pop  waiting  released by checked", "[import queue tests]") {
+    import_queue instance(10, true);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    instance.stop();
+
+    std::thread checker([&instance]() {
+        import_queue::entry entry;
+        while (instance.check(entry)) {
+            instance.checked(entry.height, true);
+        }
+    });
+
+    import_queue::entry entry;
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 42u);
+    REQUIRE( ! instance.pop(entry));
+    checker.join();
+}
+
+TEST_CASE("import_queue  spill  within memory  false", "[import queue tests]") {
+    auto const size = make_block()->serialized_size();
+    import_queue instance(10, true, 2 * size + size / 2);
+    REQUIRE(instance.start(42));
+    REQUIRE( ! instance.spill(43, size));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.memory() == size);
+    REQUIRE( ! instance.spill(43, size));
+}
+
+TEST_CASE("import_queue  spill  above memory  true unless cursor", "[import queue tests]") {
+    auto const size = make_block()->serialized_size();
+    import_queue instance(10, true, size + size / 4);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.spill(43, size));
+    REQUIRE( ! instance.spill(42, size));
+}
+
+TEST_CASE("import_queue  check  spilled above memory  deferred until cursor", "[import queue tests]") {
+    auto const size = make_block()->serialized_size();
+    import_queue instance(10, true, size + size / 4);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.push(null_hash, 43, size, 0, nullptr));
+    REQUIRE(instance.memory() == size);
+
+    import_queue::entry entry;
+    REQUIRE(instance.check(entry));
+    REQUIRE(entry.height == 42u);
+    instance.checked(42, true);
+    REQUIRE(instance.pop(entry));
+    instance.imported(42);
+    REQUIRE(instance.memory() == 0u);
+
+    // The spilled block is now at the cursor, so it is taken for loading.
+    REQUIRE(instance.check(entry));
+    REQUIRE(entry.height == 43u);
+    REQUIRE(entry.spilled);
+    REQUIRE(entry.offset == 0u);
+    REQUIRE(instance.memory() == size);
+
+    instance.checked(43, true, make_block());
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.block);
+    REQUIRE( ! entry.spilled);
+    REQUIRE(instance.memory() == 0u);
+}
+
+TEST_CASE("import_queue  check  stopped spilled above memory  checked before exit", "[import queue tests]") {
+    auto const size = make_block()->serialized_size();
+    import_queue instance(10, true, size + size / 4);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.push(null_hash, 43, size, 0, nullptr));
+    instance.stop();
+
+    std::thread checker([&instance]() {
+        import_queue::entry entry;
+        while (instance.check(entry)) {
+            auto const loaded = entry.spilled ? make_block() : nullptr;
+            instance.checked(entry.height, true, loaded);
+        }
+    });
+
+    // The spilled block is checked once it reaches the cursor.
+    import_queue::entry entry;
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 42u);
+    instance.imported(42);
+    REQUIRE(instance.pop(entry));
+    REQUIRE(entry.height == 43u);
+    instance.imported(43);
+    REQUIRE( ! instance.pop(entry));
+    checker.join();
+}
+
+TEST_CASE("import_queue  check  stopped missing cursor  false", "[import queue tests]") {
+    auto const size = make_block()->serialized_size();
+    import_queue instance(10, true, size + size / 4);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(make_block(), 42, nullptr));
+    REQUIRE(instance.push(null_hash, 44, size, 0, nullptr));
+    instance.stop();
+
+    std::thread checker([&instance]() {
+        import_queue::entry entry;
+        while (instance.check(entry)) {
+            instance.checked(entry.height, true);
+        }
+    });
+
+    // The import ends at the missing block 43, so 44 is left unchecked.
+    import_queue::entry entry;
+    REQUIRE(instance.pop(entry));
+    instance.imported(42);
+    REQUIRE( ! instance.pop(entry));
+    checker.join();
+    REQUIRE(instance.size() == 1u);
+}
+
+TEST_CASE("import_queue  checked  spilled invalid  memory released", "[import queue tests]") {
+    auto const size = make_block()->serialized_size();
+    import_queue instance(10, true, size + size / 4);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(null_hash, 42, size, 0, nullptr));
+
+    import_queue::entry entry;
+    REQUIRE(instance.check(entry));
+    REQUIRE(instance.memory() == size);
+    instance.checked(42, false);
+    REQUIRE(instance.empty());
+    REQUIRE(instance.memory() == 0u);
+}
+
+TEST_CASE("import_queue  prefetch  spilled  skipped", "[import queue tests]") {
+    auto const size = make_block()->serialized_size();
+    import_queue instance(10, true, size + size / 4);
+    REQUIRE(instance.start(42));
+    REQUIRE(instance.push(null_hash, 42, size, 0, nullptr));
+    REQUIRE(instance.push(make_block(), 43, nullptr));
+
+    import_queue::list blocks;
+    REQUIRE(instance.prefetch(blocks, 2));
+    REQUIRE(blocks.size() == 1u);
+    REQUIRE(blocks.front().height == 43u);
+}
+
+// End Test Suite
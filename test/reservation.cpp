@@ -1,3 +1,194 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+#include "utility.hpp"
+
+using namespace kth;
+using namespace kth::node;
+using namespace kth::node::test;
+
+// Start Test Suite: reservation tests
+
+static
+reservation::ptr make_row(reservations& reserves, size_t count) {
+    auto const row = std::make_shared<reservation>(reserves, 0, 5);
+
+    for (size_t height = 0; height < count; ++height) {
+        row->insert(make_hash(height), height);
+    }
+
+    return row;
+}
+
+// request
+//-----------------------------------------------------------------------------
+
+TEST_CASE("reservation  request  idle  minimum window lowest", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 2000);
+    auto const packet = row->request(false);
+    REQUIRE(packet.inventories().size() == 16u);
+    REQUIRE(packet.inventories().front().hash() == make_hash(0));
+    REQUIRE(packet.inventories().back().hash() == make_hash(15));
+}
+
+TEST_CASE("reservation  request  slow rate  minimum window", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 2000);
+    row->set_rate({ false, 1, 0, 1000000000 });
+    REQUIRE(row->request(false).inventories().size() == 16u);
+}
+
+TEST_CASE("reservation  request  fast rate  maximum window", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 2000);
+    row->set_rate({ false, 1000000000, 0, 1 });
+    REQUIRE(row->request(false).inventories().size() == 1024u);
+}
+
+// 5 bytes per microsecond for the 5 second timeout, of 250000 byte blocks.
+TEST_CASE("reservation  request  rate  blocks within timeout", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 2000);
+    row->set_rate({ false, 5, 0, 1 });
+    REQUIRE(row->request(false).inventories().size() == 100u);
+}
+
+TEST_CASE("reservation  request  half window in flight  empty", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 2000);
+    REQUIRE(row->request(false).inventories().size() == 16u);
+    REQUIRE(row->request(false).inventories().empty());
+}
+
+TEST_CASE("reservation  request  half window received  topped up", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 2000);
+    REQUIRE(row->request(false).inventories().size() == 16u);
+
+    size_t height;
+
+    for (size_t received = 0; received < 8; ++received) {
+        REQUIRE(row->find_height_and_erase(make_hash(received), height));
+    }
+
+    auto const packet = row->request(false);
+    REQUIRE(packet.inventories().size() == 8u);
+    REQUIRE(packet.inventories().front().hash() == make_hash(16));
+}
+
+TEST_CASE("reservation  request  new channel  window requested again", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 2000);
+    row->set_rate({ false, 1000000000, 0, 1 });
+    REQUIRE(row->request(false).inventories().size() == 1024u);
+
+    // A new channel resets the rate, so only the minimum window is requested.
+    auto const packet = row->request(true);
+    REQUIRE(packet.inventories().size() == 16u);
+    REQUIRE(packet.inventories().front().hash() == make_hash(0));
+}
+
+// partition
+//-----------------------------------------------------------------------------
+
+static
+std::vector<size_t> heights(reservation const& row) {
+    check_list::checks checks;
+    row.lowest(row.size(), checks);
+
+    std::vector<size_t> out;
+
+    for (auto const& check: checks) {
+        out.push_back(check.height());
+    }
+
+    return out;
+}
+
+TEST_CASE("reservation  partition  minimal not empty  true unchanged", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 10);
+    auto const minimal = std::make_shared<reservation>(reserves, 1, 5);
+    minimal->insert(make_hash(42), 42);
+    REQUIRE(row->partition(minimal));
+    REQUIRE(row->size() == 10u);
+    REQUIRE(minimal->size() == 1u);
+}
+
+TEST_CASE("reservation  partition  one hash  false", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 1);
+    auto const minimal = std::make_shared<reservation>(reserves, 1, 5);
+    REQUIRE( ! row->partition(minimal));
+    REQUIRE(row->size() == 1u);
+    REQUIRE(minimal->empty());
+}
+
+TEST_CASE("reservation  partition  two hashes  highest moved", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 2);
+    auto const minimal = std::make_shared<reservation>(reserves, 1, 5);
+    REQUIRE(row->partition(minimal));
+    REQUIRE(heights(*row) == std::vector<size_t>{ 0 });
+    REQUIRE(heights(*minimal) == std::vector<size_t>{ 1 });
+}
+
+TEST_CASE("reservation  partition  equal estimates  upper half moved", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 10);
+    auto const minimal = std::make_shared<reservation>(reserves, 1, 5);
+    REQUIRE(row->partition(minimal));
+    REQUIRE(heights(*row) == std::vector<size_t>{ 0, 1, 2, 3, 4 });
+    REQUIRE(heights(*minimal) == std::vector<size_t>{ 5, 6, 7, 8, 9 });
+}
+
+TEST_CASE("reservation  partition  requested  moved hashes requested by minimal", "[reservation tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row = make_row(reserves, 10);
+    row->set_rate({ false, 1000000000, 0, 1 });
+    REQUIRE(row->request(false).inventories().size() == 10u);
+
+    auto const minimal = std::make_shared<reservation>(reserves, 1, 5);
+    REQUIRE(row->partition(minimal));
+
+    auto const packet = minimal->request(false);
+    REQUIRE(packet.inventories().size() == 5u);
+    REQUIRE(packet.inventories().front().hash() == make_hash(5));
+}
+
+// End Test Suite
+
 // // Copyright (c) 2016-2024 Knuth Project developers.
 // // Distributed under the MIT software license, see the accompanying
 // // file COPYING or http://www.opensource.org/licenses/mit-license.php.
@@ -1,3 +1,397 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cstddef>
+#include <memory>
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+#include "utility.hpp"
+
+using namespace kth;
+using namespace kth::node;
+using namespace kth::node::test;
+
+// Start Test Suite: reservations tests
+
+static
+performance make_rate(size_t events) {
+    return { false, events, 0, 1 };
+}
+
+static
+performance const idle_rate{ true, 0, 0, 0 };
+
+// rates
+//-----------------------------------------------------------------------------
+
+TEST_CASE("reservations  rates  default  zeros", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const rates = reserves.rates();
+    REQUIRE(rates.active_count == 0u);
+    REQUIRE(rates.arithmentic_mean == 0.0);
+    REQUIRE(rates.standard_deviation == 0.0);
+}
+
+TEST_CASE("reservations  update_rates  idle to idle  unchanged", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    reserves.update_rates(idle_rate, idle_rate);
+    REQUIRE(reserves.rates().active_count == 0u);
+}
+
+TEST_CASE("reservations  update_rates  two rates  mean and deviation", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    reserves.update_rates(idle_rate, make_rate(1));
+    reserves.update_rates(idle_rate, make_rate(3));
+    auto const rates = reserves.rates();
+    REQUIRE(rates.active_count == 2u);
+    REQUIRE(rates.arithmentic_mean == 2.0);
+    REQUIRE(rates.standard_deviation == 1.0);
+}
+
+TEST_CASE("reservations  update_rates  replaced rate  previous removed", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    reserves.update_rates(idle_rate, make_rate(1));
+    reserves.update_rates(idle_rate, make_rate(3));
+    reserves.update_rates(make_rate(1), make_rate(5));
+    auto const rates = reserves.rates();
+    REQUIRE(rates.active_count == 2u);
+    REQUIRE(rates.arithmentic_mean == 4.0);
+    REQUIRE(rates.standard_deviation == 1.0);
+}
+
+TEST_CASE("reservations  update_rates  rate to idle  excluded", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    reserves.update_rates(idle_rate, make_rate(1));
+    reserves.update_rates(idle_rate, make_rate(3));
+    reserves.update_rates(make_rate(3), idle_rate);
+    auto const rates = reserves.rates();
+    REQUIRE(rates.active_count == 1u);
+    REQUIRE(rates.arithmentic_mean == 1.0);
+    REQUIRE(rates.standard_deviation == 0.0);
+}
+
+TEST_CASE("reservations  update_rates  last removed  zeros", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    reserves.update_rates(idle_rate, make_rate(3));
+    reserves.update_rates(make_rate(3), idle_rate);
+    auto const rates = reserves.rates();
+    REQUIRE(rates.active_count == 0u);
+    REQUIRE(rates.arithmentic_mean == 0.0);
+    REQUIRE(rates.standard_deviation == 0.0);
+}
+
+TEST_CASE("reservations  update_rates  row rates  statistics", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const row1 = std::make_shared<reservation>(reserves, 1, 5);
+    auto const row2 = std::make_shared<reservation>(reserves, 2, 5);
+    row1->set_rate(make_rate(1));
+    row2->set_rate(make_rate(3));
+    row1->set_rate(make_rate(5));
+    auto const rates = reserves.rates();
+    REQUIRE(rates.active_count == 2u);
+    REQUIRE(rates.arithmentic_mean == 4.0);
+    REQUIRE(rates.standard_deviation == 1.0);
+}
+
+// add
+//-----------------------------------------------------------------------------
+
+TEST_CASE("reservations  add  empty table  nullptr", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    REQUIRE( ! reserves.add());
+    REQUIRE(reserves.table().empty());
+}
+
+TEST_CASE("reservations  add  hashes remain  reserved to new row", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 99);
+    node::settings config;
+    config.sync_peers = 4;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    REQUIRE(reserves.table().size() == 3u);
+    REQUIRE(hashes.size() == 1u);
+
+    auto const row = reserves.add();
+    REQUIRE(row);
+    REQUIRE(row->slot() == 3u);
+    REQUIRE(row->size() == 1u);
+    REQUIRE(hashes.empty());
+    REQUIRE(reserves.table().size() == 4u);
+}
+
+TEST_CASE("reservations  add  no hashes  partitions maximal", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 98);
+    node::settings config;
+    config.sync_peers = 4;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    REQUIRE(hashes.empty());
+
+    auto const row = reserves.add();
+    REQUIRE(row);
+    REQUIRE(row->size() == 16u);
+    REQUIRE(reserves.table()[0]->size() == 17u);
+}
+
+// regulate
+//-----------------------------------------------------------------------------
+
+TEST_CASE("reservations  regulate  hashes remain below peers  true", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 99);
+    node::settings config;
+    config.sync_peers = 4;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    REQUIRE(reserves.regulate());
+}
+
+TEST_CASE("reservations  regulate  peers reached  false", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 99);
+    node::settings config;
+    config.sync_peers = 3;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    REQUIRE( ! reserves.regulate());
+}
+
+TEST_CASE("reservations  regulate  no hashes  false", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 98);
+    node::settings config;
+    config.sync_peers = 4;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    REQUIRE( ! reserves.regulate());
+}
+
+#if ! defined(KTH_DB_READONLY)
+TEST_CASE("reservations  regulate  added row without gain  slowest retired", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 99);
+    node::settings config;
+    config.sync_peers = 4;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+    table[0]->set_rate(make_rate(2));
+    table[1]->set_rate(make_rate(1));
+    table[2]->set_rate(make_rate(3));
+
+    // Throughput with the added row does not exceed that before it.
+    REQUIRE(reserves.import(std::make_shared<domain::message::block const>(), 0));
+    REQUIRE(reserves.regulate());
+    REQUIRE( ! reserves.regulate());
+    REQUIRE( ! table[0]->retired());
+    REQUIRE(table[1]->retired());
+    REQUIRE( ! table[2]->retired());
+}
+
+TEST_CASE("reservations  regulate  retired  backs off", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 99);
+    node::settings config;
+    config.sync_peers = 4;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+    table[0]->set_rate(make_rate(2));
+    table[1]->set_rate(make_rate(1));
+
+    REQUIRE(reserves.import(std::make_shared<domain::message::block const>(), 0));
+    REQUIRE(reserves.regulate());
+    REQUIRE( ! reserves.regulate());
+    REQUIRE(table[1]->retired());
+
+    for (size_t call = 0; call < 6; ++call) {
+        REQUIRE( ! reserves.regulate());
+    }
+
+    // The retired row is not counted, so a row may be added again.
+    REQUIRE(reserves.regulate());
+}
+
+TEST_CASE("reservations  regulate  one active row  not retired", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 99);
+    node::settings config;
+    config.sync_peers = 4;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+    table[0]->set_rate(make_rate(1));
+
+    // Idle rows are not retired, and the last active row is retained.
+    REQUIRE(reserves.import(std::make_shared<domain::message::block const>(), 0));
+    REQUIRE(reserves.regulate());
+    REQUIRE( ! reserves.regulate());
+    REQUIRE( ! table[0]->retired());
+    REQUIRE( ! table[1]->retired());
+    REQUIRE( ! table[2]->retired());
+}
+#endif
+
+// endgame
+//-----------------------------------------------------------------------------
+
+TEST_CASE("reservations  populate  no hashes to reserve or partition  lowest duplicated", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 2);
+    node::settings config;
+    config.sync_peers = 3;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+
+    size_t height;
+    REQUIRE(table[2]->find_height_and_erase(make_hash(2), height));
+    REQUIRE(reserves.populate(table[2]));
+    REQUIRE(table[2]->size() == 2u);
+    REQUIRE(table[0]->size() == 1u);
+    REQUIRE(table[1]->size() == 1u);
+}
+
+TEST_CASE("reservations  cancel  duplicated  removed from other rows", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 2);
+    node::settings config;
+    config.sync_peers = 3;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+
+    size_t height;
+    REQUIRE(table[2]->find_height_and_erase(make_hash(2), height));
+    REQUIRE(reserves.populate(table[2]));
+
+    // The first copy is imported by the original row.
+    REQUIRE(table[0]->find_height_and_erase(make_hash(0), height));
+    reserves.cancel(make_hash(0));
+    REQUIRE(table[2]->size() == 1u);
+    REQUIRE( ! table[2]->find_height_and_erase(make_hash(0), height));
+}
+
+TEST_CASE("reservations  cancel  not duplicated  rows unchanged", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 5);
+    node::settings config;
+    config.sync_peers = 3;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+    reserves.cancel(make_hash(0));
+    REQUIRE(table[0]->size() == 2u);
+}
+
+TEST_CASE("reservations  regulate  stalled import  lowest duplicated to fastest row", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 47);
+    node::settings config;
+    config.sync_peers = 3;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+    table[1]->set_rate(make_rate(1));
+    table[2]->set_rate(make_rate(2));
+
+    // The lowest height is held by the idle first row, while others have work.
+    REQUIRE( ! reserves.regulate());
+    REQUIRE(table[2]->size() == 16u);
+    REQUIRE( ! reserves.regulate());
+    REQUIRE(table[0]->size() == 16u);
+    REQUIRE(table[1]->size() == 16u);
+    REQUIRE(table[2]->size() == 32u);
+
+    // Hashes already duplicated are not duplicated again.
+    REQUIRE( ! reserves.regulate());
+    REQUIRE( ! reserves.regulate());
+    REQUIRE(table[2]->size() == 32u);
+
+    size_t height;
+    REQUIRE(table[0]->find_height_and_erase(make_hash(0), height));
+    reserves.cancel(make_hash(0));
+    REQUIRE(table[2]->size() == 31u);
+}
+
+#if ! defined(KTH_DB_READONLY)
+TEST_CASE("reservations  regulate  import advancing  not duplicated", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 47);
+    node::settings config;
+    config.sync_peers = 3;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+    table[1]->set_rate(make_rate(1));
+    table[2]->set_rate(make_rate(2));
+
+    REQUIRE( ! reserves.regulate());
+    REQUIRE(reserves.import(std::make_shared<domain::message::block const>(), 0));
+    REQUIRE( ! reserves.regulate());
+    REQUIRE( ! reserves.regulate());
+    REQUIRE(table[2]->size() == 16u);
+}
+#endif
+
+TEST_CASE("reservations  regulate  stalled without active row  unchanged", "[reservations tests]") {
+    check_list hashes;
+    fill(hashes, 0, 47);
+    node::settings config;
+    config.sync_peers = 3;
+    DECLARE_RESERVATIONS(reserves, hashes, config);
+    auto const table = reserves.table();
+
+    REQUIRE( ! reserves.regulate());
+    REQUIRE( ! reserves.regulate());
+    REQUIRE(table[0]->size() == 16u);
+    REQUIRE(table[1]->size() == 16u);
+    REQUIRE(table[2]->size() == 16u);
+}
+
+#if ! defined(KTH_DB_READONLY)
+TEST_CASE("reservations  import  at last checkpoint  inserted", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    config.sync_peers = 1;
+    threadpool pool("");
+    chain_fixture chain(pool, false, true);
+    sync_state state(state_path());
+    reservations reserves(hashes, state, chain, config);
+    REQUIRE( ! reserves.import(std::make_shared<domain::message::block const>(), 0));
+}
+
+TEST_CASE("reservations  import  above last checkpoint  organized", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    config.sync_peers = 1;
+    threadpool pool("");
+    chain_fixture chain(pool, false, true);
+    sync_state state(state_path());
+    reservations reserves(hashes, state, chain, config);
+    REQUIRE(reserves.import(std::make_shared<domain::message::block const>(), 1));
+}
+
+TEST_CASE("reservations  import  rejected above last checkpoint  false", "[reservations tests]") {
+    check_list hashes;
+    node::settings config;
+    config.sync_peers = 1;
+    threadpool pool("");
+    chain_fixture chain(pool, true, false);
+    sync_state state(state_path());
+    reservations reserves(hashes, state, chain, config);
+    REQUIRE( ! reserves.import(std::make_shared<domain::message::block const>(), 1));
+}
+#endif
+
+// End Test Suite
+
 // // Copyright (c) 2016-2024 Knuth Project developers.
 // // Distributed under the MIT software license, see the accompanying
 // // file COPYING or http://www.opensource.org/licenses/mit-license.php.
@@ -16,6 +16,8 @@ TEST_CASE("settings construct default context expected", "[settings tests]") {
     node::settings configuration;
     REQUIRE(configuration.sync_peers == 0u);
     REQUIRE(configuration.sync_timeout_seconds == 5u);
+    REQUIRE(configuration.sync_memory_megabytes == 1024u);
+    REQUIRE(configuration.block_race_peers == 1u);
     REQUIRE(configuration.refresh_transactions == true);
 }
 
@@ -0,0 +1,91 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <vector>
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+
+// Start Test Suite: short id table tests
+
+// The SipHash-2-4 reference key, bytes 0x00 through 0x0f.
+static
+short_id_table::key const reference_key{ 0x0706050403020100, 0x0f0e0d0c0b0a0908 };
+
+static
+hash_digest make_hash(uint8_t first) {
+    hash_digest hash;
+
+    for (size_t byte = 0; byte < hash.size(); ++byte) {
+        hash[byte] = static_cast<uint8_t>(first + byte);
+    }
+
+    return hash;
+}
+
+TEST_CASE("short_id_table  short_id  reference vector  expected", "[short id table tests]") {
+    // SipHash-2-4 of bytes 0x00 through 0x1f is 0x7127512f72f27cce.
+    REQUIRE(short_id_table::short_id(reference_key, make_hash(0)) == 0x512f72f27cceu);
+}
+
+TEST_CASE("short_id_table  short_id  other key  expected", "[short id table tests]") {
+    short_id_table::key const key{ 0x0123456789abcdef, 0xfedcba9876543210 };
+    hash_digest hash;
+
+    for (size_t byte = 0; byte < hash.size(); ++byte) {
+        hash[byte] = static_cast<uint8_t>(hash.size() - byte);
+    }
+
+    REQUIRE(short_id_table::short_id(key, hash) == 0xfe7269b8df07u);
+}
+
+TEST_CASE("short_id_table  short_ids  contiguous hashes  match short_id", "[short id table tests]") {
+    size_t const count = 11;
+    std::vector<hash_digest> hashes;
+
+    for (size_t index = 0; index < count; ++index) {
+        hashes.push_back(make_hash(static_cast<uint8_t>(index)));
+    }
+
+    std::vector<uint64_t> ids(count);
+    short_id_table::short_ids(reference_key, hashes.data(), count, ids.data());
+
+    for (size_t index = 0; index < count; ++index) {
+        REQUIRE(ids[index] == short_id_table::short_id(reference_key, hashes[index]));
+    }
+}
+
+TEST_CASE("short_id_table  find  inserted  found", "[short id table tests]") {
+    short_id_table instance(100);
+
+    for (uint16_t index = 0; index < 100; ++index) {
+        REQUIRE(instance.insert(uint64_t(index) * 0x10001, index));
+    }
+
+    REQUIRE(instance.size() == 100u);
+
+    for (uint16_t index = 0; index < 100; ++index) {
+        uint16_t found;
+        REQUIRE(instance.find(uint64_t(index) * 0x10001, found));
+        REQUIRE(found == index);
+    }
+
+    uint16_t found;
+    REQUIRE( ! instance.find(42, found));
+}
+
+TEST_CASE("short_id_table  insert  duplicate  false", "[short id table tests]") {
+    short_id_table instance(2);
+    REQUIRE(instance.insert(42, 0));
+    REQUIRE( ! instance.insert(42, 1));
+    REQUIRE(instance.size() == 1u);
+
+    uint16_t found;
+    REQUIRE(instance.find(42, found));
+    REQUIRE(found == 0u);
+}
+
+// End Test Suite
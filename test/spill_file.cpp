@@ -0,0 +1,124 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <filesystem>
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+
+// Start Test Suite: spill file tests
+
+static
+std::filesystem::path test_path() {
+    return std::filesystem::temp_directory_path() / "kth_spill_file_test";
+}
+
+static
+data_chunk load(spill_file const& file, uint64_t offset, uint64_t size) {
+    data_chunk out;
+    auto const copy = [&out](uint8_t const* data, size_t size) {
+        out.assign(data, data + size);
+    };
+
+    REQUIRE(file.load(offset, size, copy));
+    return out;
+}
+
+TEST_CASE("spill_file  store  closed  false", "[spill file tests]") {
+    spill_file instance(test_path());
+    uint64_t offset;
+    REQUIRE( ! instance.store({ 1, 2, 3 }, offset));
+    REQUIRE(instance.size() == 0u);
+}
+
+TEST_CASE("spill_file  open  twice  false", "[spill file tests]") {
+    spill_file instance(test_path());
+    REQUIRE(instance.open());
+    REQUIRE( ! instance.open());
+}
+
+TEST_CASE("spill_file  close  open  file removed", "[spill file tests]") {
+    spill_file instance(test_path());
+    REQUIRE(instance.open());
+    REQUIRE(std::filesystem::exists(test_path()));
+    instance.close();
+    REQUIRE( ! std::filesystem::exists(test_path()));
+}
+
+TEST_CASE("spill_file  store  two ranges  loaded", "[spill file tests]") {
+    spill_file instance(test_path());
+    REQUIRE(instance.open());
+
+    uint64_t first;
+    uint64_t second;
+    REQUIRE(instance.store({ 1, 2, 3 }, first));
+    REQUIRE(instance.store({ 4, 5 }, second));
+    REQUIRE(instance.size() == 5u);
+    REQUIRE(first == 0u);
+    REQUIRE(second == 3u);
+    REQUIRE(load(instance, first, 3) == data_chunk{ 1, 2, 3 });
+    REQUIRE(load(instance, second, 2) == data_chunk{ 4, 5 });
+}
+
+TEST_CASE("spill_file  load  beyond stored  false", "[spill file tests]") {
+    spill_file instance(test_path());
+    REQUIRE(instance.open());
+
+    uint64_t offset;
+    REQUIRE(instance.store({ 1, 2, 3 }, offset));
+    REQUIRE( ! instance.load(offset, 4, [](uint8_t const*, size_t) {}));
+}
+
+TEST_CASE("spill_file  release  first range  reused", "[spill file tests]") {
+    spill_file instance(test_path());
+    REQUIRE(instance.open());
+
+    uint64_t first;
+    uint64_t second;
+    uint64_t third;
+    REQUIRE(instance.store({ 1, 2, 3 }, first));
+    REQUIRE(instance.store({ 4, 5 }, second));
+    instance.release(first, 3);
+    REQUIRE(instance.size() == 2u);
+
+    REQUIRE(instance.store({ 6, 7 }, third));
+    REQUIRE(third == first);
+    REQUIRE(load(instance, third, 2) == data_chunk{ 6, 7 });
+    REQUIRE(load(instance, second, 2) == data_chunk{ 4, 5 });
+}
+
+TEST_CASE("spill_file  release  all  rewound", "[spill file tests]") {
+    spill_file instance(test_path());
+    REQUIRE(instance.open());
+
+    uint64_t first;
+    uint64_t second;
+    REQUIRE(instance.store({ 1, 2, 3 }, first));
+    REQUIRE(instance.store({ 4, 5 }, second));
+    instance.release(second, 2);
+    instance.release(first, 3);
+    REQUIRE(instance.size() == 0u);
+
+    uint64_t offset;
+    REQUIRE(instance.store({ 6 }, offset));
+    REQUIRE(offset == 0u);
+}
+
+TEST_CASE("spill_file  store  above capacity  grown", "[spill file tests]") {
+    spill_file instance(test_path());
+    REQUIRE(instance.open());
+
+    uint64_t first;
+    uint64_t second;
+    data_chunk const large(64 * 1024 * 1024, 0x2a);
+    REQUIRE(instance.store({ 1, 2, 3 }, first));
+    REQUIRE(instance.store(large, second));
+    REQUIRE(second == 3u);
+    REQUIRE(load(instance, first, 3) == data_chunk{ 1, 2, 3 });
+    REQUIRE(load(instance, second, large.size()) == large);
+}
+
+// End Test Suite
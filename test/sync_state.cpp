@@ -0,0 +1,136 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <filesystem>
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+using namespace kth::domain::chain;
+
+// Start Test Suite: sync state tests
+
+static
+std::filesystem::path test_path() {
+    return std::filesystem::temp_directory_path() / "kth_sync_state_test";
+}
+
+static
+header::list make_headers(size_t count, hash_digest previous = null_hash) {
+    header::list headers;
+
+    for (uint32_t index = 0; index < count; ++index) {
+        headers.emplace_back(1u, previous, null_hash, index, 0x1d00ffffu, index);
+        previous = headers.back().hash();
+    }
+
+    return headers;
+}
+
+TEST_CASE("sync_state  open  missing  false", "[sync state tests]") {
+    std::filesystem::remove(test_path());
+    sync_state instance(test_path());
+
+    size_t first;
+    header::list headers;
+    REQUIRE( ! instance.open(first, headers));
+    REQUIRE( ! instance.append(make_headers(1), 0));
+}
+
+TEST_CASE("sync_state  create  open  empty at height", "[sync state tests]") {
+    sync_state instance(test_path());
+    REQUIRE(instance.create(42));
+    REQUIRE(instance.next_height() == 42u);
+
+    size_t first;
+    header::list headers;
+    sync_state reopened(test_path());
+    REQUIRE(reopened.open(first, headers));
+    REQUIRE(first == 42u);
+    REQUIRE(headers.empty());
+    REQUIRE(reopened.import_height() == 42u);
+    instance.remove();
+}
+
+TEST_CASE("sync_state  set import height  open  headers retained", "[sync state tests]") {
+    auto const headers = make_headers(3);
+    sync_state instance(test_path());
+    REQUIRE( ! instance.set_import_height(43));
+    REQUIRE(instance.create(42));
+    REQUIRE(instance.append(headers, 42));
+    REQUIRE(instance.set_import_height(44));
+    REQUIRE(instance.import_height() == 44u);
+
+    size_t first;
+    header::list out;
+    sync_state reopened(test_path());
+    REQUIRE(reopened.open(first, out));
+    REQUIRE(reopened.import_height() == 44u);
+    REQUIRE(out == headers);
+    reopened.remove();
+}
+
+TEST_CASE("sync_state  append  not continuing  false", "[sync state tests]") {
+    sync_state instance(test_path());
+    REQUIRE(instance.create(42));
+    REQUIRE( ! instance.append(make_headers(2), 43));
+    REQUIRE(instance.append(make_headers(2), 42));
+    REQUIRE(instance.next_height() == 44u);
+    REQUIRE( ! instance.append(make_headers(1), 42));
+    instance.remove();
+}
+
+TEST_CASE("sync_state  append  slots  read in order", "[sync state tests]") {
+    auto const headers = make_headers(5);
+    header::list const low(headers.begin(), headers.begin() + 2);
+    header::list const high(headers.begin() + 2, headers.end());
+
+    sync_state instance(test_path());
+    REQUIRE(instance.create(42));
+    REQUIRE(instance.append(low, 42));
+    REQUIRE(instance.append(high, 44));
+
+    size_t first;
+    header::list out;
+    sync_state reopened(test_path());
+    REQUIRE(reopened.open(first, out));
+    REQUIRE(first == 42u);
+    REQUIRE(out == headers);
+    REQUIRE(reopened.next_height() == 47u);
+    reopened.remove();
+}
+
+TEST_CASE("sync_state  open  unlinked header  truncated", "[sync state tests]") {
+    sync_state instance(test_path());
+    REQUIRE(instance.create(42));
+    REQUIRE(instance.append(make_headers(2), 42));
+    REQUIRE(instance.append(make_headers(1), 44));
+
+    size_t first;
+    header::list out;
+    sync_state reopened(test_path());
+    REQUIRE(reopened.open(first, out));
+    REQUIRE(out.size() == 2u);
+    REQUIRE(reopened.next_height() == 44u);
+
+    // Appends continue from the last linked header.
+    REQUIRE(reopened.append(make_headers(1, out.back().hash()), 44));
+    REQUIRE(sync_state(test_path()).open(first, out));
+    REQUIRE(out.size() == 3u);
+    reopened.remove();
+}
+
+TEST_CASE("sync_state  remove  open  false", "[sync state tests]") {
+    sync_state instance(test_path());
+    REQUIRE(instance.create(42));
+    instance.remove();
+    REQUIRE( ! instance.append(make_headers(1), 42));
+
+    size_t first;
+    header::list headers;
+    REQUIRE( ! instance.open(first, headers));
+}
+
+// End Test Suite
@@ -7,12 +7,29 @@
 #ifndef KTH_NODE_TEST_HELPERS_HPP
 #define KTH_NODE_TEST_HELPERS_HPP
 
+#include <cstddef>
+#include <cstdint>
+
 #include <catch2/catch_test_macros.hpp>
 
 // #define CHECK_MESSAGE(cond, msg) do { INFO(msg); CHECK(cond); } while((void)0, 0)
 // #define REQUIRE_MESSAGE(cond, msg) do { INFO(msg); REQUIRE(cond); } while((void)0, 0)
 
-// #include <kth/infrastructure.hpp>
+#include <kth/infrastructure.hpp>
 // #include <kth/domain.hpp>
 
+namespace kth::node::test {
+
+// Distinct hash for each value below 2^24.
+inline
+hash_digest make_hash(size_t value) {
+    auto hash = null_hash;
+    hash[0] = static_cast<uint8_t>(value);
+    hash[1] = static_cast<uint8_t>(value >> 8);
+    hash[2] = static_cast<uint8_t>(value >> 16);
+    return hash;
+}
+
+} // namespace kth::node::test
+
 #endif // KTH_NODE_TEST_HELPERS_HPP
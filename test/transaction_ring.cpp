@@ -0,0 +1,73 @@
+// Copyright (c) 2016-2024 Knuth Project developers.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <memory>
+#include <vector>
+#include <test_helpers.hpp>
+#include <kth/node.hpp>
+
+using namespace kth;
+using namespace kth::node;
+
+// Start Test Suite: transaction ring tests
+
+static
+short_id_table::key const test_key{ 0x0706050403020100, 0x0f0e0d0c0b0a0908 };
+
+static
+transaction_const_ptr make_transaction(uint32_t locktime) {
+    domain::chain::transaction const transaction(1, locktime, {}, {});
+    return std::make_shared<domain::message::transaction const>(transaction);
+}
+
+static
+short_id_table make_table(transaction_const_ptr const& transaction, uint16_t index) {
+    short_id_table table(1);
+    REQUIRE(table.insert(short_id_table::short_id(test_key, transaction->hash()), index));
+    return table;
+}
+
+TEST_CASE("transaction_ring  store  beyond capacity  size capped", "[transaction ring tests]") {
+    transaction_ring instance(2);
+    instance.store(make_transaction(1));
+    instance.store(make_transaction(2));
+    instance.store(make_transaction(3));
+    REQUIRE(instance.size() == 2u);
+}
+
+TEST_CASE("transaction_ring  fill  matching short id  placed", "[transaction ring tests]") {
+    auto const transaction = make_transaction(1);
+    transaction_ring instance(2);
+    instance.store(make_transaction(2));
+    instance.store(transaction);
+
+    std::vector<domain::chain::transaction> out(3);
+    REQUIRE(instance.fill(test_key, make_table(transaction, 1), out) == 1u);
+    REQUIRE( ! out[0].is_valid());
+    REQUIRE(out[1].hash() == transaction->hash());
+    REQUIRE( ! out[2].is_valid());
+}
+
+TEST_CASE("transaction_ring  fill  position valid  not replaced", "[transaction ring tests]") {
+    auto const transaction = make_transaction(1);
+    auto const existing = make_transaction(2);
+    transaction_ring instance(2);
+    instance.store(transaction);
+
+    std::vector<domain::chain::transaction> out{ *existing };
+    REQUIRE(instance.fill(test_key, make_table(transaction, 0), out) == 0u);
+    REQUIRE(out[0].hash() == existing->hash());
+}
+
+TEST_CASE("transaction_ring  store  full  oldest replaced", "[transaction ring tests]") {
+    auto const oldest = make_transaction(1);
+    transaction_ring instance(1);
+    instance.store(oldest);
+    instance.store(make_transaction(2));
+
+    std::vector<domain::chain::transaction> out(1);
+    REQUIRE(instance.fill(test_key, make_table(oldest, 0), out) == 0u);
+}
+
+// End Test Suite
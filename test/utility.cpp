@@ -9,6 +9,7 @@
 #include <cstdint>
 #include <thread>
 #include <kth/node.hpp>
+#include <test_helpers.hpp>
 
 namespace kth::node::test {
 
@@ -27,6 +28,18 @@ infrastructure::config::checkpoint const check42 {
 const infrastructure::config::checkpoint::list no_checks;
 const infrastructure::config::checkpoint::list one_check{ check42 };
 
+void fill(check_list& hashes, size_t first, size_t last) {
+    hashes.reserve(first, last);
+
+    for (auto height = first; height <= last; ++height) {
+        hashes.enqueue(make_hash(height), height);
+    }
+}
+
+std::filesystem::path state_path() {
+    return std::filesystem::temp_directory_path() / "kth_test_sync_state";
+}
+
 // Create a headers message of specified size, starting with a genesis header.
 domain::message::headers::ptr message_factory(size_t count) {
     return message_factory(count, null_hash);
@@ -76,6 +89,27 @@ std::chrono::high_resolution_clock::time_point reservation_fixture::now() const
 
 // ----------------------------------------------------------------------------
 
+chain_fixture::chain_fixture(threadpool& pool, bool insert_result, bool organize_result)
+    : block_chain(pool, blockchain::settings{}, database::settings{},
+        domain::config::network::mainnet)
+    , insert_result_(insert_result)
+    , organize_result_(organize_result)
+{}
+
+#if ! defined(KTH_DB_READONLY)
+// Stub
+bool chain_fixture::insert(block_const_ptr block, size_t height) {
+    return insert_result_;
+}
+#endif
+
+// Stub
+void chain_fixture::organize(block_const_ptr block, result_handler handler) {
+    handler(organize_result_ ? error::success : error::operation_failed);
+}
+
+// ----------------------------------------------------------------------------
+
 blockchain_fixture::blockchain_fixture(bool import_result, size_t gap_trigger, size_t gap_height)
     : import_result_(import_result)
     , gap_trigger_(gap_trigger)
@@ -8,22 +8,28 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <kth/node.hpp>
 
 namespace kth::node::test {
 
-#define DECLARE_RESERVATIONS(name, import) \
-infrastructure::config::checkpoint::list checkpoints; \
-header_queue hashes(checkpoints); \
-blockchain_fixture blockchain(import); \
-node::settings config; \
-reservations name(hashes, blockchain, config)
+#define DECLARE_RESERVATIONS(name, hashes, config) \
+threadpool pool_##name(""); \
+chain_fixture chain_##name(pool_##name); \
+sync_state state_##name(state_path()); \
+reservations name(hashes, state_##name, chain_##name, config)
 
 extern infrastructure::config::checkpoint const check0;
 extern infrastructure::config::checkpoint const check42;
 extern const infrastructure::config::checkpoint::list no_checks;
 extern const infrastructure::config::checkpoint::list one_check;
 
+// Reserve and enqueue make_hash(height) for each height of [first, last].
+void fill(check_list& hashes, size_t first, size_t last);
+
+// A path for a sync state file, which is not created by the fixtures.
+std::filesystem::path state_path();
+
 // Create a headers message of specified size, using specified previous hash.
 extern domain::message::headers::ptr message_factory(size_t count);
 extern domain::message::headers::ptr message_factory(size_t count,
@@ -42,6 +48,24 @@ private:
     clock::time_point now_;
 };
 
+// An unstarted chain, which reservations only write to by import.
+// It has no checkpoints, so blocks above the genesis height are organized.
+class chain_fixture : public blockchain::block_chain {
+public:
+    chain_fixture(threadpool& pool, bool insert_result=true,
+        bool organize_result=true);
+
+#if ! defined(KTH_DB_READONLY)
+    bool insert(block_const_ptr block, size_t height) override;
+#endif
+
+    void organize(block_const_ptr block, result_handler handler) override;
+
+private:
+    bool insert_result_;
+    bool organize_result_;
+};
+
 class blockchain_fixture : public blockchain::fast_chain {
 public:
     blockchain_fixture(bool import_result=true, size_t gap_trigger=max_size_t,